@@ -2,12 +2,45 @@
 #define _SIMPLE_ARG_PARSER_
 
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
 #include <tuple>
+#include <utility>
 #include <vector>
 #include <map>
+#include <memory>
 #include <sstream>
+#include <atomic>
+#include <exception>
+#include <initializer_list>
+#include <thread>
+#include <functional>
+#include <mutex>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   define SIMPLE_ARG_PARSER_MMAP 1
+#   define SIMPLE_ARG_PARSER_POSIX 1
+#   include <fcntl.h>
+#   include <sys/ioctl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#else
+#   define SIMPLE_ARG_PARSER_MMAP 0
+#   define SIMPLE_ARG_PARSER_POSIX 0
+#   include <fstream>
+#endif
 
 #if defined(DEBUG)
 #   define LOG(MSG) std::cout << MSG << std::endl
@@ -17,352 +50,6578 @@
 #   define LOG_VAR(V)
 #endif // DEBUG
 
+// Without exceptions (-fno-exceptions), errors that would
+// throw print the message and abort. Use tryParse to get
+// parsing errors as values instead
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#   define SIMPLE_ARG_PARSER_EXCEPTIONS 1
+#   define SIMPLE_ARG_PARSER_THROW(EXCEPTION) throw EXCEPTION
+#else
+#   define SIMPLE_ARG_PARSER_EXCEPTIONS 0
+#   define SIMPLE_ARG_PARSER_THROW(EXCEPTION) parser::detail::fail(EXCEPTION)
+#endif
+
 
 namespace parser
 {
 
-    /** Exception thrown when there's a parsing error
-    *   during runtime. It inherits from std::runtime_error.
-    *   Its message explains which argument is unexpected, 
-    *   as well as the correct usage
+    /** Destination of the texts written by the parsers
+    *   (e.g. writeUsage). It's created implicitly from a
+    *   std::ostream, a FILE* or a std::string (which is
+    *   appended to), or from a caller buffer, which is
+    *   never overflowed and always ends with '\0':
+    *
+    *       schema.writeUsage(std::cout);
+    *       schema.writeUsage(stderr);
+    *       schema.writeUsage(parser::output_sink::descriptor(2));
+    *
+    *       char buffer[4096];
+    *       schema.writeUsage({ buffer, sizeof(buffer) });
+    *
+    *   The text goes straight to the destination, so
+    *   writing doesn't allocate (except for a growing
+    *   std::string). The sink counts what was written to
+    *   it, including what didn't fit in a buffer
     */
-    class parsing_exception : public std::runtime_error{
-    
+    class output_sink
+    {
     protected:
-        /** Usage of the command-line arguments
+        /** Kind of destination
+        */
+        typedef enum {
+            DISCARD=0,
+            STREAM,
+            FILE_STREAM,
+            DESCRIPTOR,
+            MEMORY,
+            STRING
+        } sink_kind;
+
+        /** Kind of destination
+        */
+        sink_kind _kind;
+
+        /** Destination, according to _kind
+        */
+        std::ostream* _stream;
+        std::FILE* _file;
+        int _descriptor;
+        char* _memory;
+        std::string* _string;
+
+        /** Capacity of _memory
+        */
+        std::size_t _memorySize;
+
+        /** Length of the text given to the sink
+        */
+        std::size_t _written;
+
+        /** Text waiting to be written to _descriptor, so
+        *   the system is called once per block
+        */
+        char _pending[512];
+
+        /** Length of the text in _pending
+        */
+        std::size_t _pendingSize;
+
+        /** Creates a sink of a given kind
+        */
+        explicit output_sink(sink_kind kind, int descriptor = -1) :
+            _kind(kind),
+            _stream(nullptr),
+            _file(nullptr),
+            _descriptor(descriptor),
+            _memory(nullptr),
+            _string(nullptr),
+            _memorySize(0),
+            _written(0),
+            _pendingSize(0)
+        { }
+
+    public:
+
+        /** Sink that only counts the text given to it
+        */
+        output_sink() : output_sink(DISCARD)
+        { }
+
+        /** Sink writing to a stream
+        */
+        output_sink(std::ostream& stream) : output_sink(STREAM)
+        {
+            this->_stream = &stream;
+        }
+
+        /** Sink writing to a C stream
+        */
+        output_sink(std::FILE* file) : output_sink(FILE_STREAM)
+        {
+            this->_file = file;
+        }
+
+        /** Sink appending to a string
+        */
+        output_sink(std::string& text) : output_sink(STRING)
+        {
+            this->_string = &text;
+        }
+
+        /** Sink writing to a caller buffer. Text that
+        *   doesn't fit is dropped (but counted)
+        *
+        *   @param buffer
+        *       the buffer
+        *
+        *   @param size
+        *       capacity of the buffer, including the '\0'
+        */
+        output_sink(char* buffer, std::size_t size) : output_sink(MEMORY)
+        {
+            this->_memory = buffer;
+            this->_memorySize = size;
+            if(size > 0)
+                buffer[0] = '\0';
+        }
+
+#if SIMPLE_ARG_PARSER_POSIX
+        /** Sink writing to a file descriptor
+        *
+        *   @param descriptor
+        *       the file descriptor (e.g. 2 for stderr)
+        */
+        static output_sink descriptor(int descriptor)
+        {
+            return output_sink(DESCRIPTOR, descriptor);
+        }
+#endif
+
+        output_sink(const output_sink&) = delete;
+        output_sink& operator=(const output_sink&) = delete;
+
+        ~output_sink()
+        {
+            this->flush();
+        }
+
+        /** Writes a text
+        */
+        void put(std::string_view text)
+        {
+            std::size_t offset = this->_written;
+            this->_written += text.size();
+            switch(this->_kind)
+            {
+            case STREAM:
+                this->_stream->write(text.data(), static_cast<std::streamsize>(text.size()));
+                break;
+            case FILE_STREAM:
+                std::fwrite(text.data(), 1, text.size(), this->_file);
+                break;
+            case STRING:
+                this->_string->append(text);
+                break;
+            case MEMORY:
+                if(offset + 1 < this->_memorySize)
+                {
+                    std::size_t size = std::min(text.size(), this->_memorySize - 1 - offset);
+                    std::copy(text.begin(), text.begin() + size, this->_memory + offset);
+                    this->_memory[offset + size] = '\0';
+                }
+                break;
+            case DESCRIPTOR:
+                while(!text.empty())
+                {
+                    if(this->_pendingSize == sizeof(this->_pending))
+                        this->flush();
+                    std::size_t size = std::min(text.size(), sizeof(this->_pending) - this->_pendingSize);
+                    std::copy(text.begin(), text.begin() + size, this->_pending + this->_pendingSize);
+                    this->_pendingSize += size;
+                    text.remove_prefix(size);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        /** Writes a character a number of times
+        */
+        void put(char c, std::size_t count = 1)
+        {
+            for(std::size_t i = 0; i < count; i++)
+                this->put(std::string_view(&c, 1));
+        }
+
+        /** Sends the pending text to the file descriptor
+        */
+        void flush()
+        {
+#if SIMPLE_ARG_PARSER_POSIX
+            std::size_t done = 0;
+            while(done < this->_pendingSize)
+            {
+                ssize_t result = ::write(this->_descriptor, this->_pending + done, this->_pendingSize - done);
+                if(result <= 0)
+                    break;
+                done += static_cast<std::size_t>(result);
+            }
+#endif
+            this->_pendingSize = 0;
+        }
+
+        /** Length of the text given to the sink
+        */
+        std::size_t written() const
+        {
+            return this->_written;
+        }
+
+        /** Descriptor of the file the sink writes to, or -1
+        *   if it doesn't write to a file (e.g. a buffer)
+        */
+        int fileDescriptor() const
+        {
+            switch(this->_kind)
+            {
+            case STREAM:
+                if(this->_stream == &std::cout)
+                    return 1;
+                if(this->_stream == &std::cerr || this->_stream == &std::clog)
+                    return 2;
+                return -1;
+            case FILE_STREAM:
+#if SIMPLE_ARG_PARSER_POSIX
+                return ::fileno(this->_file);
+#else
+                return this->_file == stdout ? 1 : this->_file == stderr ? 2 : -1;
+#endif
+            case DESCRIPTOR:
+                return this->_descriptor;
+            default:
+                return -1;
+            }
+        }
+
+        /** Width used by writeUsage when none is given: the
+        *   width of the terminal the sink writes to, or 80
+        *   columns if it isn't a terminal
+        */
+        static constexpr std::size_t TERMINAL_WIDTH = static_cast<std::size_t>(-1);
+    };
+
+
+    /** Internal helpers shared by the parsers. Not part
+    *   of the public interface
+    */
+    namespace detail
+    {
+
+#if !SIMPLE_ARG_PARSER_EXCEPTIONS
+        /** Reports an error that can't be thrown and
+        *   aborts the program
+        *
+        *   @param error
+        *       the exception that would be thrown
+        */
+        template <typename Exception>
+        [[noreturn]] void fail(const Exception& error)
+        {
+            std::fputs(error.what(), stderr);
+            std::fputc('\n', stderr);
+            std::abort();
+        }
+#endif
+
+        /** 64-bit FNV-1a hash of an argument name. It's
+        *   constexpr so the static schemas can be hashed
+        *   at compile time
+        *
+        *   @param [in] name
+        *       text to be hashed
+        *
+        *   @param [in] hash
+        *       hash of the text before it, to hash a name
+        *       given in pieces
+        */
+        constexpr std::uint64_t hashName(
+            std::string_view name,
+            std::uint64_t hash = 14695981039346656037ull)
+        {
+            for(char c : name)
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        /** Cheap integer finalizer (from splitmix64) used to
+        *   derive table slots from a name hash and a
+        *   displacement, so the name is hashed only once
+        */
+        constexpr std::uint64_t mixHash(std::uint64_t hash)
+        {
+            hash ^= hash >> 30;
+            hash *= 0xbf58476d1ce4e5b9ull;
+            hash ^= hash >> 27;
+            hash *= 0x94d049bb133111ebull;
+            hash ^= hash >> 31;
+            return hash;
+        }
+
+        /** Index of the lowest bit set in a non-zero word
+        */
+        inline unsigned lowestBit(std::uint64_t word)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+            unsigned index = 0;
+            while(!(word & 1))
+            {
+                word >>= 1;
+                index++;
+            }
+            return index;
+#endif
+        }
+
+        /** Cheap pre-filter of the tokens that can be
+        *   argument names: the set of first bytes of the
+        *   names and the range of their lengths. Tokens
+        *   outside it (most values and file names) are
+        *   rejected without hashing them
+        */
+        struct name_filter
+        {
+            /** Bitmap of the first bytes of the names
+            */
+            std::uint64_t firstBytes[4] = { 0, 0, 0, 0 };
+
+            /** Length of the shortest name
+            */
+            std::size_t minLength = static_cast<std::size_t>(-1);
+
+            /** Length of the longest name
+            */
+            std::size_t maxLength = 0;
+
+            /** Includes a name in the filter
+            */
+            constexpr void add(std::string_view name)
+            {
+                if(!name.empty())
+                {
+                    unsigned char first = static_cast<unsigned char>(name[0]);
+                    firstBytes[first >> 6] |= std::uint64_t(1) << (first & 63);
+                }
+                minLength = std::min(minLength, name.size());
+                maxLength = std::max(maxLength, name.size());
+            }
+
+            /** Indicates if a token can be one of the names
+            */
+            constexpr bool mayContain(std::string_view token) const
+            {
+                if(token.size() < minLength || token.size() > maxLength)
+                    return false;
+                if(token.empty())
+                    return true;
+                unsigned char first = static_cast<unsigned char>(token[0]);
+                return (firstBytes[first >> 6] >> (first & 63)) & 1;
+            }
+        };
+
+        /** Smallest power of two able to hold twice the
+        *   given number of entries
+        */
+        constexpr std::size_t tableSizeFor(std::size_t entries)
+        {
+            std::size_t size = 1;
+            while(size < 2 * entries)
+                size *= 2;
+            return size;
+        }
+
+        /** Width of a terminal in columns, read from the
+        *   terminal or the COLUMNS variable. Descriptors
+        *   that aren't a terminal (files, pipes) get 80
+        *
+        *   @param descriptor
+        *       descriptor of the terminal, or -1
+        */
+        inline std::size_t terminalWidth(int descriptor)
+        {
+            if(descriptor < 0)
+                return 80;
+#if SIMPLE_ARG_PARSER_POSIX
+            if(!::isatty(descriptor))
+                return 80;
+
+            winsize size;
+            if(::ioctl(descriptor, TIOCGWINSZ, &size) == 0 && size.ws_col > 0)
+                return size.ws_col;
+#else
+            if(descriptor > 2)
+                return 80;
+#endif
+            const char* columns = std::getenv("COLUMNS");
+            std::size_t value = 0;
+            if(columns != nullptr)
+            {
+                std::string_view text(columns);
+                std::from_chars(text.data(), text.data() + text.size(), value);
+            }
+            return value > 0 ? value : 80;
+        }
+
+        /** Writes the usage text shared by all the parsers.
+        *
+        *   @param sink
+        *       destination of the text
+        *
+        *   @param [in] programName
+        *       name of the program, shown in the first line
+        *
+        *   @param [in] width
+        *       number of columns to wrap the text to, 0 to
+        *       keep each part in a single line, or
+        *       output_sink::TERMINAL_WIDTH
+        *
+        *   @param [in] forEachArgument
+        *       callable receiving a visitor, that must call it
+        *       as visitor(name, hasValue, description) for
+        *       every argument, in the order to be shown
+        */
+        template <typename ForEach>
+        void writeUsageText(
+            output_sink& sink,
+            std::string_view programName,
+            std::size_t width,
+            ForEach forEachArgument)
+        {
+            if(width == output_sink::TERMINAL_WIDTH)
+                width = terminalWidth(sink.fileDescriptor());
+
+            sink.put("  Usage:\n    ");
+            sink.put(programName);
+            sink.put(' ');
+
+            // Continuation lines are aligned after the program
+            // name, unless it takes most of the line
+            std::size_t column = 4 + programName.size() + 1;
+            std::size_t indent = std::min(column, width / 2);
+            bool lineStart = true;
+            forEachArgument([&](std::string_view name,
+                                bool hasValue,
+                                std::string_view)
+            {
+                std::size_t length = 3 + name.size() + (hasValue ? 4 : 1);
+                if(width != 0 && !lineStart)
+                {
+                    if(column + 2 + length > width)
+                    {
+                        sink.put('\n');
+                        sink.put(' ', indent);
+                        column = indent;
+                    }
+                    else
+                    {
+                        sink.put("  ");
+                        column += 2;
+                    }
+                }
+
+                sink.put("[ ");
+                sink.put(name);
+                sink.put(hasValue ? " val]" : " ]");
+                if(width == 0)
+                    sink.put("  ");
+                column += length;
+                lineStart = false;
+            });
+            sink.put("\n\n");
+
+            forEachArgument([&](std::string_view name,
+                                bool hasValue,
+                                std::string_view description)
+            {
+                if(description.empty())
+                    return;
+
+                sink.put("    [ ");
+                sink.put(name);
+                sink.put(hasValue ? " val] => " : " ] => ");
+                if(width == 0)
+                {
+                    sink.put(description);
+                    sink.put("\n\n");
+                    return;
+                }
+
+                // Word wrap, with the continuation lines
+                // indented under the argument
+                const std::size_t hanging = 8;
+                std::size_t position = 6 + name.size() + (hasValue ? 9 : 6);
+                bool firstWord = true;
+                while(!description.empty())
+                {
+                    std::size_t end = description.find(' ');
+                    std::string_view word = description.substr(0, end);
+                    description.remove_prefix(end == std::string_view::npos ? description.size() : end + 1);
+                    if(word.empty())
+                        continue;
+
+                    if(!firstWord && position + 1 + word.size() > width)
+                    {
+                        sink.put('\n');
+                        sink.put(' ', hanging);
+                        position = hanging;
+                    }
+                    else if(!firstWord)
+                    {
+                        sink.put(' ');
+                        position++;
+                    }
+                    sink.put(word);
+                    position += word.size();
+                    firstWord = false;
+                }
+                sink.put("\n\n");
+            });
+
+            sink.put("\n\n");
+        }
+
+        /** Renders the usage text shared by all the parsers
+        *   into a string, without wrapping. The text is
+        *   measured first, so the string is allocated once
+        *
+        *   @param [in] programName
+        *       name of the program, shown in the first line
+        *
+        *   @param [in] forEachArgument
+        *       same as in writeUsageText
+        */
+        template <typename ForEach>
+        std::string usageText(std::string_view programName, ForEach forEachArgument)
+        {
+            output_sink counter;
+            writeUsageText(counter, programName, 0, forEachArgument);
+
+            std::string text;
+            text.reserve(counter.written());
+            output_sink sink(text);
+            writeUsageText(sink, programName, 0, forEachArgument);
+            return text;
+        }
+
+        /** Texts needed to render the usage of a Schema,
+        *   copied once by freeze() into a block shared with
+        *   the exceptions it throws, so they can render the
+        *   usage when asked, even after the schema is gone
+        */
+        class usage_model
+        {
+        protected:
+            /** An argument, as offsets into _text
+            */
+            typedef struct
+            {
+                std::size_t name;
+                std::size_t nameSize;
+                std::size_t description;
+                std::size_t descriptionSize;
+                bool hasValue;
+            } usage_entry;
+
+            /** Program name followed by the names and
+            *   descriptions of all the arguments
+            */
+            std::string _text;
+
+            /** Length of the program name in _text
+            */
+            std::size_t _programNameSize;
+
+            /** Arguments, in the order they are shown
+            */
+            std::vector<usage_entry> _entries;
+
+        public:
+
+            /** Copies the texts of the arguments
+            *
+            *   @param [in] programName
+            *       name of the program
+            *
+            *   @param [in] forEachArgument
+            *       same as in writeUsageText
+            */
+            template <typename ForEach>
+            usage_model(std::string_view programName, ForEach forEachArgument) :
+                _programNameSize(programName.size())
+            {
+                // Measured first, so each buffer is allocated once
+                std::size_t length = programName.size();
+                std::size_t count = 0;
+                forEachArgument([&length, &count](std::string_view name, bool, std::string_view description)
+                {
+                    length += name.size() + description.size();
+                    count++;
+                });
+                this->_text.reserve(length);
+                this->_entries.reserve(count);
+
+                this->_text.append(programName);
+                forEachArgument([this](std::string_view name, bool hasValue, std::string_view description)
+                {
+                    std::size_t offset = this->_text.size();
+                    this->_text.append(name);
+                    this->_text.append(description);
+                    this->_entries.push_back({ offset, name.size(),
+                        offset + name.size(), description.size(), hasValue });
+                });
+            }
+
+            /** Renders the usage, like Schema::usage()
+            */
+            std::string render() const
+            {
+                std::string_view text(this->_text);
+                return usageText(text.substr(0, this->_programNameSize), [this, text](auto&& visitor)
+                {
+                    for(auto&& entry : this->_entries)
+                        visitor(text.substr(entry.name, entry.nameSize), entry.hasValue,
+                            text.substr(entry.description, entry.descriptionSize));
+                });
+            }
+        };
+    }
+
+
+    /** Kinds of errors found while parsing
+    */
+    enum class parse_errc
+    {
+        /** The token is not a registered argument
+        */
+        unexpected_argument = 1,
+
+        /** The response file given as @path can't be read
+        */
+        unreadable_response_file,
+
+        /** The response file has an unterminated quote
+        *   or escape
+        */
+        malformed_response_file,
+
+        /** The value can't be converted to the type of the
+        *   variable bound to the argument
+        */
+        invalid_value,
+
+        /** A required argument is missing (the token is
+        *   its name)
+        */
+        missing_argument,
+
+        /** Two mutually exclusive arguments were given (the
+        *   token is the name of one of them)
+        */
+        excluded_argument,
+
+        /** An argument needed by another one given is
+        *   missing (the token is its name)
+        */
+        missing_dependency,
+
+        /** None of a group of alternative arguments was
+        *   given (the token is the name of the first one)
+        */
+        missing_alternative,
+
+        /** A value was given to an argument that takes
+        *   none, as in --flag=value
+        */
+        unexpected_value,
+
+        /** The input ended before the value of the
+        *   last argument
+        */
+        missing_value
+    };
+
+
+    /** Outcome of a parse that doesn't throw. On
+    *   success, code is parse_errc() (zero)
+    */
+    struct parse_status
+    {
+        /** Kind of the error, or parse_errc() on success
+        */
+        parse_errc code;
+
+        /** Index of the offending token in argv, or -1
+        */
+        int index;
+
+        /** Offending token, pointing into argv (or into
+        *   a response file)
+        */
+        std::string_view token;
+
+        /** Indicates if the parse succeeded
+        */
+        explicit operator bool() const
+        {
+            return this->code == parse_errc();
+        }
+    };
+
+
+    /** Shells supported by the completion scripts
+    */
+    enum class completion_shell
+    {
+        bash,
+
+        /** Uses the bash script, through bashcompinit
+        */
+        zsh
+    };
+
+
+    namespace detail
+    {
+
+        /** Answers a completion request, given by the
+        *   shell as:
+        *
+        *       program __complete <cword> <words...>
+        *
+        *   where words are the words of the command-line
+        *   (starting with the program) and cword is the
+        *   index of the word being completed. The candidates
+        *   are written one per line. Nothing is written when
+        *   the word is the value of an argument, so the
+        *   shell completes it as a file
+        *
+        *   @param argc, argv
+        *       the input received by main
+        *
+        *   @param out
+        *       stream receiving the candidates
+        *
+        *   @param takesValue
+        *       callable telling if a name is an argument
+        *       followed by a value
+        *
+        *   @param forEachMatch
+        *       callable receiving a prefix and a visitor, to be
+        *       called with each name starting with the prefix
+        *
+        *   @return false if the input isn't a completion
+        *       request
+        */
+        template <typename TakesValue, typename ForEachMatch>
+        bool answerCompletion(
+            int argc,
+            char** argv,
+            std::ostream& out,
+            TakesValue takesValue,
+            ForEachMatch forEachMatch)
+        {
+            if(argc < 3 || std::string_view(argv[1]) != "__complete")
+                return false;
+
+            std::string_view cwordText(argv[2]);
+            int cword = 0;
+            auto [end, error] = std::from_chars(
+                cwordText.data(), cwordText.data() + cwordText.size(), cword);
+            int words = argc - 3;
+            if(error != std::errc() || end != cwordText.data() + cwordText.size() ||
+               cword < 1 || cword > words)
+                return true;
+
+            if(cword >= 2 && takesValue(std::string_view(argv[3 + cword - 1])))
+                return true;
+
+            std::string_view prefix = cword < words ? argv[3 + cword] : "";
+            forEachMatch(prefix, [&out](std::string_view name)
+            {
+                out << name << '\n';
+            });
+            out.flush();
+            return true;
+        }
+
+        /** Writes text quoted for the shell, between
+        *   single quotes, so no character in it is special
+        */
+        inline void writeShellQuoted(std::ostream& out, std::string_view text)
+        {
+            out << '\'';
+            for(char c : text)
+            {
+                if(c == '\'')
+                    out << "'\\''";
+                else
+                    out << c;
+            }
+            out << '\'';
+        }
+
+        /** Writes a completion script that asks the program
+        *   for the candidates, running it as
+        *
+        *       program __complete <cword> <words...>
+        *
+        *   (see answerCompletion). The program knows its
+        *   subcommands and the arguments of each one, and no
+        *   name is ever written into the script. When there's
+        *   no candidate (e.g. the value of an argument) the
+        *   shell completes files
+        *
+        *   @param out
+        *       stream receiving the script
+        *
+        *   @param shell
+        *       shell running the script
+        *
+        *   @param programName
+        *       name of the program (argv[0])
+        */
+        inline void writeCompletionScript(
+            std::ostream& out,
+            completion_shell shell,
+            std::string_view programName)
+        {
+            std::string_view command = programName.substr(programName.find_last_of('/') + 1);
+            std::string function = "_";
+            for(char c : command)
+                function += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+            function += "_complete";
+
+            if(shell == completion_shell::zsh)
+            {
+                out << "#compdef ";
+                writeShellQuoted(out, command);
+                out << "\n\n"
+                    << "autoload -U +X bashcompinit && bashcompinit\n\n";
+            }
+
+            out << function << "()\n{\n"
+                << "    local IFS=$'\\n'\n"
+                << "    COMPREPLY=( $(\"$1\" __complete \"$COMP_CWORD\" \"${COMP_WORDS[@]}\" 2>/dev/null) )\n"
+                << "}\n\n"
+                << "complete -o default -F " << function << ' ';
+            writeShellQuoted(out, command);
+            out << '\n';
+        }
+
+        /** Renders the usage of a schema whose usage()
+        *   receives the program name (e.g. StaticSchema)
+        */
+        template <typename Schema>
+        auto renderUsage(const Schema& schema, std::string_view programName, int)
+            -> decltype(schema.usage(programName))
+        {
+            return schema.usage(programName);
+        }
+
+        /** Renders the usage of a schema that already knows
+        *   the program name (e.g. ArgumentParser)
+        */
+        template <typename Schema>
+        auto renderUsage(const Schema& schema, std::string_view, long)
+            -> decltype(schema.usage())
+        {
+            return schema.usage();
+        }
+
+        /** Copy of a schema without a usage_model (the
+        *   compile-time ones), kept by an exception to render
+        *   the usage when asked. Those schemas only hold
+        *   views of their texts, so copying them is cheap
+        */
+        template <typename Schema>
+        struct usage_snapshot
+        {
+            Schema schema;
+            std::string programName;
+
+            std::string render() const
+            {
+                return renderUsage(this->schema, this->programName, 0);
+            }
+        };
+
+        /** Source of the usage of an exception: the object
+        *   it shares, and how to render it
+        */
+        typedef struct
+        {
+            std::shared_ptr<const void> source;
+            std::string (*render)(const void*);
+        } usage_source;
+
+        /** Renders the usage of a usage_model or a
+        *   usage_snapshot
+        */
+        template <typename Source>
+        std::string renderSource(const void* source)
+        {
+            return static_cast<const Source*>(source)->render();
+        }
+
+        /** Usage source of a Schema: its usage_model, shared
+        */
+        template <typename Schema>
+        auto usageSourceOf(const Schema& schema, std::string_view, int)
+            -> decltype(schema.usageModel(), usage_source())
+        {
+            return usage_source{ schema.usageModel(), &renderSource<usage_model> };
+        }
+
+        /** Usage source of any other schema: a snapshot
+        */
+        template <typename Schema>
+        usage_source usageSourceOf(const Schema& schema, std::string_view programName, long)
+        {
+            auto snapshot = std::make_shared<usage_snapshot<Schema>>(
+                usage_snapshot<Schema>{ schema, std::string(programName) });
+            return usage_source{ std::move(snapshot), &renderSource<usage_snapshot<Schema>> };
+        }
+    }
+
+
+    /** Exception thrown when there's a parsing error
+    *   during runtime. It inherits from std::runtime_error.
+    *   Its message explains which argument is unexpected, 
+    *   as well as the correct usage.
+    *
+    *   When thrown by the parsers, the message is written
+    *   into a fixed buffer inside the exception, and the
+    *   usage is only rendered when usage() or message() is
+    *   called, from texts the exception shares with the
+    *   schema. So the exception is self-contained: it can
+    *   outlive the parser that threw it and be read by many
+    *   threads. Only token() still points into argv (or
+    *   into a response file kept alive by the exception);
+    *   tokens owned by the schema, such as the names of
+    *   required arguments, are copied after the message
+    */
+    class parsing_exception : public std::runtime_error{
+    
+    protected:
+        /** Usage of the command-line arguments, when given
+        *   to the constructor
+        */
+        std::string _usage;
+
+        /** Texts of the schema that threw the exception,
+        *   rendered by usage(), or empty
+        */
+        detail::usage_source _usageSource;
+
+        /** Kind of the error
+        */
+        parse_errc _code;
+
+        /** Offending token, pointing into argv
+        */
+        std::string_view _token;
+
+        /** Index of the offending token in argv, or -1
+        *   if unknown
+        */
+        int _index;
+
+        /** Message written when thrown by the parsers, or
+        *   empty when the texts were given to the constructor.
+        *   Long tokens are shortened to fit
+        */
+        char _message[256];
+
+        /** Position in _message of the copy of the token
+        *   (see keepTokenCopy), or 0 if it isn't copied. An
+        *   offset, so copies of the exception use their own
+        */
+        std::size_t _tokenCopy;
+
+        /** Keeps alive the storage of the token, when it
+        *   doesn't point into argv (e.g. a response file)
+        */
+        std::shared_ptr<const void> _tokenStorage;
+
+    public:
+
+        /** Basic constructor for const string
+        *
+        *   @param msg
+        *       Message explaining the error found
+        *
+        *   @param usage
+        *       Usage of the command-line arguments
+        *
+        */
+        parsing_exception(
+            const std::string& _msg,
+            const std::string& _usage) :
+            std::runtime_error(_msg),
+            _usage(_usage),
+            _usageSource(),
+            _code(parse_errc::unexpected_argument),
+            _index(-1),
+            _message(),
+            _tokenCopy(0)
+        { }
+
+
+        /** Basic constructor for const char*
+        *
+        *   @param msg
+        *       Message explaining the error found
+        *
+        *   @param usage
+        *       Usage of the command-line arguments
+        *
+        */
+        parsing_exception(
+            const char* _msg,
+            const char* _usage) :
+            std::runtime_error(_msg),
+            _usage(_usage),
+            _usageSource(),
+            _code(parse_errc::unexpected_argument),
+            _index(-1),
+            _message(),
+            _tokenCopy(0)
+        { }
+
+
+        /** Constructor used by the parsers
+        *
+        *   @param code
+        *       Kind of the error
+        *
+        *   @param token
+        *       Unexpected token (a view into argv)
+        *
+        *   @param index
+        *       Index of the token in argv
+        *
+        *   @param schema
+        *       Schema used in the parsing. It must have a
+        *       usage() or usage(programName) method. Its texts
+        *       are shared (a Schema) or copied (the compile-time
+        *       schemas, which only hold views), but the usage
+        *       isn't rendered until asked
+        *
+        *   @param programName
+        *       Name of the program, when the schema
+        *       doesn't know it
+        */
+        template <typename Schema>
+        parsing_exception(
+            parse_errc code,
+            std::string_view token,
+            int index,
+            const Schema& schema,
+            std::string_view programName = std::string_view()) :
+            std::runtime_error("Error parsing the arguments."),
+            _usageSource(detail::usageSourceOf(schema, programName, 0)),
+            _code(code),
+            _token(token),
+            _index(index),
+            _message(),
+            _tokenCopy(0)
+        {
+            this->writeMessage();
+        }
+
+
+        /** Constructor used by the parsers for unexpected
+        *   arguments
+        *
+        *   @param token
+        *       Unexpected token (a view into argv)
+        *
+        *   @param index
+        *       Index of the token in argv
+        *
+        *   @param schema
+        *       Schema used in the parsing
+        *
+        *   @param programName
+        *       Name of the program, when the schema
+        *       doesn't know it
+        */
+        template <typename Schema>
+        parsing_exception(
+            std::string_view token,
+            int index,
+            const Schema& schema,
+            std::string_view programName = std::string_view()) :
+            parsing_exception(
+                parse_errc::unexpected_argument,
+                token, index, schema, programName)
+        { }
+
+        /** Explains the error
+        */
+        const char* what() const noexcept override
+        {
+            if(this->_message[0] == '\0')
+                return std::runtime_error::what();
+            return this->_message;
+        }
+
+        /** Makes the exception share the ownership of the
+        *   storage of its token, so the token stays valid
+        *   even if the parse result is destroyed
+        *
+        *   @param storage
+        *       owner of the memory the token points into
+        */
+        void keepTokenAlive(std::shared_ptr<const void> storage)
+        {
+            this->_tokenStorage = std::move(storage);
+        }
+
+        /** Copies the token into the exception, after the
+        *   message, for tokens owned by the parser instead of
+        *   argv (e.g. the name of a required argument). It's
+        *   shortened if it doesn't fit in the space left
+        */
+        void keepTokenCopy()
+        {
+            std::size_t start = std::char_traits<char>::length(this->_message) + 1;
+            if(start >= sizeof(this->_message))
+                return;
+
+            std::size_t size = std::min(this->_token.size(), sizeof(this->_message) - start);
+            std::copy(this->_token.begin(), this->_token.begin() + size, this->_message + start);
+            this->_token = this->_token.substr(0, size);
+            this->_tokenCopy = start;
+        }
+
+        /** Returns the kind of the error
+        */
+        parse_errc code() const
+        {
+            return this->_code;
+        }
+
+        /** Returns the offending token (empty if the
+        *   exception was built from the texts)
+        */
+        std::string_view token() const
+        {
+            if(this->_tokenCopy != 0)
+                return std::string_view(this->_message + this->_tokenCopy, this->_token.size());
+            return this->_token;
+        }
+
+        /** Returns the index of the offending token in
+        *   argv, or -1 if unknown. Tokens read from a
+        *   response file have the index of the @path
+        */
+        int index() const
+        {
+            return this->_index;
+        }
+
+        /** Returns the usage of the CLI, rendered from the
+        *   schema on each call
+        */
+        std::string usage() const
+        {
+            if(this->_usageSource.render != nullptr)
+                return this->_usageSource.render(this->_usageSource.source.get());
+            return this->_usage;
+        }
+
+
+        std::string message() const
+        {
+            std::string msg = this->what();
+            msg += "\n";
+            msg += this->usage();
+            return msg;
+        }
+
+    protected:
+
+        /** Writes the message of _code and _token into
+        *   _message, without allocating
+        */
+        void writeMessage()
+        {
+            const std::size_t maxToken = 160;
+            std::string_view token = this->_token;
+            if(this->_code == parse_errc::unreadable_response_file ||
+               this->_code == parse_errc::malformed_response_file)
+                token = token.substr(1);
+
+            const char* prefix = "Argument '";
+            const char* suffix = "' not expected.\n";
+            switch(this->_code)
+            {
+            case parse_errc::unreadable_response_file:
+                prefix = "Response file '";
+                suffix = "' can't be read.\n";
+                break;
+            case parse_errc::malformed_response_file:
+                prefix = "Response file '";
+                suffix = "' has an unterminated quote or escape.\n";
+                break;
+            case parse_errc::invalid_value:
+                prefix = "Value '";
+                suffix = "' has an invalid format or is out of range.\n";
+                break;
+            case parse_errc::missing_argument:
+                suffix = "' is required.\n";
+                break;
+            case parse_errc::excluded_argument:
+                suffix = "' can't be given with the other arguments.\n";
+                break;
+            case parse_errc::missing_dependency:
+                suffix = "' is required by the other arguments.\n";
+                break;
+            case parse_errc::missing_alternative:
+                suffix = "' or one of its alternatives is required.\n";
+                break;
+            case parse_errc::unexpected_value:
+                suffix = "' doesn't take a value.\n";
+                break;
+            case parse_errc::missing_value:
+                suffix = "' requires a value.\n";
+                break;
+            default:
+                break;
+            }
+
+            output_sink sink(this->_message, sizeof(this->_message));
+            sink.put(prefix);
+            if(token.size() > maxToken)
+            {
+                sink.put(token.substr(0, maxToken));
+                sink.put("...");
+            }
+            else
+                sink.put(token);
+            sink.put(suffix);
+        }
+    };
+
+
+    /** Exception thrown when the value of an argument
+    *   can't be converted to the requested type. It
+    *   inherits from std::runtime_error and also carries
+    *   the std::errc describing the failure
+    *   (invalid_argument or result_out_of_range)
+    */
+    class conversion_exception : public std::runtime_error{
+
+    protected:
+        /** Reason of the conversion failure
+        */
+        std::errc _code;
+
+    public:
+
+        /** Basic constructor
+        *
+        *   @param msg
+        *       Message explaining the error found
+        *
+        *   @param code
+        *       Reason of the failure
+        */
+        conversion_exception(
+            const std::string& _msg,
+            std::errc _code) :
+            std::runtime_error(_msg),
+            _code(_code)
+        { }
+
+        /** Returns the reason of the conversion failure
+        */
+        std::errc code() const
+        {
+            return this->_code;
+        }
+    };
+
+
+    /** Converts the text of an argument value to the
+    *   type T, without allocating (except for std::string,
+    *   which is assigned directly).
+    *
+    *   Integers and floating point numbers go through
+    *   std::from_chars, and the whole text must be consumed.
+    *   bool accepts "1", "0", "true" and "false". Any other
+    *   type falls back to operator>>, so user types that
+    *   are streamable keep working.
+    *
+    *   @param [in] text
+    *       text to be converted
+    *
+    *   @param [out] value
+    *       converted value. Only valid on success
+    *
+    *   @return std::errc() on success,
+    *       std::errc::invalid_argument if the text is
+    *       malformed and std::errc::result_out_of_range
+    *       if the value doesn't fit in T
+    */
+    template <typename T>
+    std::errc convert(std::string_view text, T& value)
+    {
+        if constexpr (std::is_same_v<T, std::string>)
+        {
+            value.assign(text.data(), text.size());
+            return std::errc();
+        }
+        else if constexpr (std::is_same_v<T, std::string_view>)
+        {
+            value = text;
+            return std::errc();
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            if(text == "1" || text == "true")
+                value = true;
+            else if(text == "0" || text == "false")
+                value = false;
+            else
+                return std::errc::invalid_argument;
+            return std::errc();
+        }
+        else if constexpr ((std::is_integral_v<T> && !std::is_same_v<T, char>)
+                           || std::is_floating_point_v<T>)
+        {
+            const char* first = text.data();
+            const char* last = first + text.size();
+
+            // std::from_chars doesn't accept an explicit plus sign
+            if(last - first > 1 && first[0] == '+' && first[1] != '-')
+                first++;
+
+            auto result = std::from_chars(first, last, value);
+            if(result.ec != std::errc())
+                return result.ec;
+            if(result.ptr != last)
+                return std::errc::invalid_argument;
+            return std::errc();
+        }
+        else
+        {
+            std::stringstream ss;
+            ss << text;
+            ss >> value;
+            if(ss.fail() || !(ss >> std::ws).eof())
+                return std::errc::invalid_argument;
+            return std::errc();
+        }
+    }
+
+
+    namespace detail
+    {
+
+        /** Converts the value of an argument for the
+        *   getArgument methods, turning the failures into
+        *   a parser::conversion_exception
+        *
+        *   @param [in] argName
+        *       name of the argument, used in the messages
+        *
+        *   @param [in] defined
+        *       whether the argument was defined
+        *
+        *   @param [in] text
+        *       value of the argument
+        */
+        template <typename T>
+        T convertArgument(std::string_view argName, bool defined, std::string_view text)
+        {
+            if(!defined)
+            {
+                std::string msg = "Argument '";
+                msg += argName;
+                msg += "' not defined.";
+                SIMPLE_ARG_PARSER_THROW(parser::conversion_exception(msg, std::errc::invalid_argument));
+            }
+
+            T value{};
+            auto code = parser::convert(text, value);
+            if(code != std::errc())
+            {
+                std::string msg = "Value '";
+                msg += text;
+                msg += "' of argument '";
+                msg += argName;
+                msg += "' ";
+                msg += code == std::errc::result_out_of_range ?
+                    "is out of range." : "has an invalid format.";
+                SIMPLE_ARG_PARSER_THROW(parser::conversion_exception(msg, code));
+            }
+            return value;
+        }
+    }
+
+
+    namespace detail
+    {
+
+        /** Read-only view of a whole file, mapped in memory
+        *   when the platform allows it (or read into a buffer
+        *   otherwise). The mapping is private, so the contents
+        *   can be modified in place without touching the file,
+        *   and only the modified pages are copied. Pipes,
+        *   devices and files with no size to map (such as
+        *   /dev/stdin or the ones in /proc) are read instead
+        */
+        class mapped_file
+        {
+        protected:
+            /** Contents of the file
+            */
+            char* _data;
+
+            /** Size of the file
+            */
+            std::size_t _size;
+
+            /** Indicates if the file was read
+            */
+            bool _valid;
+
+            /** Indicates if the contents are mapped (and
+            *   not in the buffer)
+            */
+            bool _mapped;
+
+            /** Contents of the file, when it can't be mapped
+            */
+            std::string _buffer;
+
+#if SIMPLE_ARG_PARSER_MMAP
+            /** Reads the file until its end into the buffer
+            *
+            *   @param fd
+            *       descriptor of the open file
+            */
+            void readAll(int fd)
+            {
+                char chunk[4096];
+                while(true)
+                {
+                    ssize_t count = ::read(fd, chunk, sizeof(chunk));
+                    if(count == 0)
+                        break;
+                    if(count < 0)
+                    {
+                        if(errno == EINTR)
+                            continue;
+                        return;
+                    }
+                    this->_buffer.append(chunk, static_cast<std::size_t>(count));
+                }
+                this->_data = &this->_buffer[0];
+                this->_size = this->_buffer.size();
+                this->_valid = true;
+            }
+#endif
+
+        public:
+
+            /** Maps the file
+            *
+            *   @param path
+            *       path of the file
+            */
+            explicit mapped_file(const std::string& path) :
+                _data(nullptr), _size(0), _valid(false), _mapped(false)
+            {
+#if SIMPLE_ARG_PARSER_MMAP
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if(fd < 0)
+                    return;
+
+                struct stat info;
+                if(::fstat(fd, &info) == 0)
+                {
+                    if(S_ISREG(info.st_mode) && info.st_size > 0)
+                    {
+                        this->_size = static_cast<std::size_t>(info.st_size);
+                        void* data = ::mmap(nullptr, this->_size,
+                            PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                        if(data != MAP_FAILED)
+                        {
+                            this->_data = static_cast<char*>(data);
+                            this->_valid = true;
+                            this->_mapped = true;
+                        }
+                        else
+                            this->_size = 0;
+                    }
+                    if(!this->_valid && !S_ISDIR(info.st_mode))
+                        this->readAll(fd);
+                }
+                ::close(fd);
+#else
+                std::ifstream file(path, std::ios::binary);
+                if(!file)
+                    return;
+
+                std::stringstream contents;
+                contents << file.rdbuf();
+                this->_buffer = contents.str();
+                this->_data = &this->_buffer[0];
+                this->_size = this->_buffer.size();
+                this->_valid = true;
+#endif
+            }
+
+            mapped_file(const mapped_file&) = delete;
+            mapped_file& operator=(const mapped_file&) = delete;
+
+            ~mapped_file()
+            {
+#if SIMPLE_ARG_PARSER_MMAP
+                if(this->_mapped)
+                    ::munmap(this->_data, this->_size);
+#endif
+            }
+
+            /** Indicates if the file was read
+            */
+            bool valid() const
+            {
+                return this->_valid;
+            }
+
+            /** Contents of the file
+            */
+            char* data()
+            {
+                return this->_data;
+            }
+
+            /** Size of the file
+            */
+            std::size_t size() const
+            {
+                return this->_size;
+            }
+
+            /** Indicates if a text points into the file
+            *
+            *   @param text
+            *       text to be verified
+            */
+            bool contains(std::string_view text) const
+            {
+                return this->_data != nullptr
+                    && text.data() >= this->_data
+                    && text.data() < this->_data + this->_size;
+            }
+        };
+
+
+        /** Whitespace separating the tokens of a response file
+        */
+        constexpr bool isSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n'
+                || c == '\r' || c == '\f' || c == '\v';
+        }
+
+
+        /** Verifies that every quote and escape of a response
+        *   file is terminated, without modifying it
+        *
+        *   @param text
+        *       contents of the file
+        *
+        *   @param size
+        *       size of the contents
+        */
+        inline bool isWellFormedResponseFile(const char* text, std::size_t size)
+        {
+            char quote = 0;
+            bool escaped = false;
+            for(const char* in = text; in != text + size; in++)
+            {
+                if(escaped)
+                    escaped = false;
+                else if(*in == '\\' && quote != '\'')
+                    escaped = true;
+                else if(quote == 0 && (*in == '"' || *in == '\''))
+                    quote = *in;
+                else if(*in == quote)
+                    quote = 0;
+            }
+            return !escaped && quote == 0;
+        }
+
+
+        /** Splits the contents of a response file in tokens,
+        *   in place. The tokens are separated by whitespace,
+        *   can be quoted with single or double quotes, and a
+        *   backslash escapes the next character (except inside
+        *   single quotes). Quotes and escapes are removed by
+        *   moving the rest of the token back, so the text is
+        *   only written when they appear. A malformed file is
+        *   rejected before the first token is given, so it is
+        *   never applied in part
+        *
+        *   @param text
+        *       contents of the file, modified in place
+        *
+        *   @param size
+        *       size of the contents
+        *
+        *   @param onToken
+        *       called with a view of each token, pointing
+        *       into text. It returns false to stop
+        *
+        *   @return false if a quote or escape is unterminated,
+        *       or if onToken stopped the tokenization
+        */
+        template <typename OnToken>
+        bool tokenizeResponseFile(char* text, std::size_t size, OnToken onToken)
+        {
+            if(!isWellFormedResponseFile(text, size))
+                return false;
+
+            char* in = text;
+            char* end = text + size;
+            while(true)
+            {
+                while(in != end && isSpace(*in))
+                    in++;
+                if(in == end)
+                    return true;
+
+                char* start = in;
+                char* out = in;
+                char quote = 0;
+                while(in != end && (quote != 0 || !isSpace(*in)))
+                {
+                    char c = *in++;
+                    if(c == '\\' && quote != '\'')
+                    {
+                        if(in == end)
+                            return false;
+                        c = *in++;
+                    }
+                    else if(quote == 0 && (c == '"' || c == '\''))
+                    {
+                        quote = c;
+                        continue;
+                    }
+                    else if(c == quote)
+                    {
+                        quote = 0;
+                        continue;
+                    }
+
+                    if(out != in - 1)
+                        *out = c;
+                    out++;
+                }
+
+                if(quote != 0)
+                    return false;
+                if(!onToken(std::string_view(start, static_cast<std::size_t>(out - start))))
+                    return false;
+            }
+        }
+    }
+
+
+    /** Handle of an argument registered in a Schema
+    *   (or ArgumentParser), returned by addArgument. The
+    *   results can be accessed through it with a direct
+    *   index, instead of a lookup by name
+    */
+    struct ArgHandle
+    {
+        /** Index of the argument, in registration order
+        */
+        std::uint32_t index;
+    };
+
+
+    /** Number of values taken by an argument. E.g.:
+    *
+    *       schema.addArgument("--point", parser::arity::exactly(3));
+    *       schema.addArgument("--files", parser::arity::oneOrMore());
+    *       schema.addArgument("-I", parser::arity::repeated());
+    *
+    *   An argument taking at least the minimum of values
+    *   stops at the next token starting with a dash (or
+    *   at the maximum). A repeatable argument keeps the
+    *   values of all its occurrences; otherwise the last
+    *   occurrence replaces them
+    */
+    struct arity
+    {
+        /** Maximum of an argument taking any number of values
+        */
+        static constexpr std::uint32_t UNBOUNDED = static_cast<std::uint32_t>(-1);
+
+        std::uint32_t minimum;
+        std::uint32_t maximum;
+        bool repeatable;
+
+        /** Exactly count values (0 is a flag)
+        */
+        static constexpr arity exactly(std::uint32_t count)
+        {
+            return arity{ count, count, false };
+        }
+
+        /** One or more values, like + in a grammar
+        */
+        static constexpr arity oneOrMore()
+        {
+            return arity{ 1, UNBOUNDED, false };
+        }
+
+        /** At most one value, like ? in a grammar
+        */
+        static constexpr arity optional()
+        {
+            return arity{ 0, 1, false };
+        }
+
+        /** Any number of values, like * in a grammar
+        */
+        static constexpr arity any()
+        {
+            return arity{ 0, UNBOUNDED, false };
+        }
+
+        /** Values of an argument that can be given many
+        *   times, like -I a -I b
+        *
+        *   @param values
+        *       values taken by each occurrence
+        */
+        static constexpr arity repeated(arity values = arity{ 1, 1, false })
+        {
+            return arity{ values.minimum, values.maximum, true };
+        }
+
+        /** Indicates if the values are kept as a list,
+        *   instead of a single value
+        */
+        constexpr bool isList() const
+        {
+            return this->maximum > 0
+                && (this->repeatable || this->maximum > 1 || this->minimum != this->maximum);
+        }
+    };
+
+
+    /** Values of an argument taking many of them, as
+    *   returned by ParseResult::values. It's a view over
+    *   storage shared by all the arguments of the result,
+    *   valid until the result is parsed into again
+    */
+    class value_range
+    {
+    protected:
+        const std::string_view* _begin;
+        const std::string_view* _end;
+
+    public:
+        value_range() :
+            _begin(nullptr),
+            _end(nullptr)
+        { }
+
+        value_range(const std::string_view* begin, const std::string_view* end) :
+            _begin(begin),
+            _end(end)
+        { }
+
+        const std::string_view* begin() const
+        {
+            return this->_begin;
+        }
+
+        const std::string_view* end() const
+        {
+            return this->_end;
+        }
+
+        std::size_t size() const
+        {
+            return static_cast<std::size_t>(this->_end - this->_begin);
+        }
+
+        bool empty() const
+        {
+            return this->_begin == this->_end;
+        }
+
+        const std::string_view& operator[](std::size_t index) const
+        {
+            return this->_begin[index];
+        }
+    };
+
+
+    /** Range of tokens in argv, from argv[begin] up to
+    *   (not including) argv[end]
+    */
+    struct argv_range
+    {
+        int begin;
+        int end;
+    };
+
+
+    namespace detail
+    {
+
+        /** Function converting a value straight into the
+        *   variable bound to an argument
+        */
+        typedef std::errc (*store_function)(std::string_view, void*);
+
+        /** Converts a value into a bound variable of type T
+        *
+        *   @param text
+        *       value of the argument
+        *
+        *   @param destination
+        *       pointer to the T variable, or nullptr to only
+        *       check that the value can be converted
+        */
+        template <typename T>
+        std::errc storeValue(std::string_view text, void* destination)
+        {
+            if(destination == nullptr)
+            {
+                T value{};
+                return parser::convert(text, value);
+            }
+            return parser::convert(text, *static_cast<T*>(destination));
+        }
+
+        /** Sets a bound bool variable when its flag is given
+        *
+        *   @param destination
+        *       pointer to the bool variable, or nullptr
+        */
+        inline std::errc storeFlag(std::string_view, void* destination)
+        {
+            if(destination != nullptr)
+                *static_cast<bool*>(destination) = true;
+            return std::errc();
+        }
+
+        /** Range of work of one thread in parallelFor.
+        *   Aligned so each one has its own cache line
+        */
+        struct alignas(64) work_range
+        {
+            /** Next item to be taken, by the owner or by
+            *   any other thread stealing from it
+            */
+            std::atomic<std::size_t> next;
+
+            /** End of the range
+            */
+            std::size_t end;
+        };
+
+
+        /** Calls work(i) for every i in [0, count), using
+        *   up to the given number of threads (the calling
+        *   one included). The items are split in one range
+        *   per thread; each thread takes small chunks from
+        *   its own range and, when it's done, steals chunks
+        *   from the ranges of the others, so the load stays
+        *   balanced without any lock.
+        *
+        *   @param count
+        *       number of items
+        *
+        *   @param threads
+        *       maximum number of threads, or 0 to use
+        *       one per hardware thread
+        *
+        *   @param work
+        *       callable receiving the index of an item.
+        *       If it throws, the first exception is
+        *       rethrown after all the threads finish
+        */
+        template <typename Work>
+        void parallelFor(std::size_t count, unsigned threads, Work work)
+        {
+            const std::size_t chunk = 64;
+
+            if(threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            threads = static_cast<unsigned>(std::min<std::size_t>(
+                threads, (count + chunk - 1) / chunk));
+            if(threads <= 1)
+            {
+                for(std::size_t i = 0; i < count; i++)
+                    work(i);
+                return;
+            }
+
+            std::unique_ptr<work_range[]> ranges(new work_range[threads]);
+            for(unsigned t = 0; t < threads; t++)
+            {
+                ranges[t].next = count * t / threads;
+                ranges[t].end = count * (t + 1) / threads;
+            }
+
+            std::exception_ptr error;
+            std::atomic<bool> failed(false);
+            auto run = [&](unsigned self)
+            {
+                for(unsigned k = 0; k < threads && !failed; k++)
+                {
+                    work_range& range = ranges[(self + k) % threads];
+                    while(!failed)
+                    {
+                        std::size_t begin = range.next.fetch_add(chunk);
+                        if(begin >= range.end)
+                            break;
+                        std::size_t end = std::min(begin + chunk, range.end);
+                        for(std::size_t i = begin; i < end; i++)
+                            work(i);
+                    }
+                }
+            };
+            auto worker = [&](unsigned self)
+            {
+#if SIMPLE_ARG_PARSER_EXCEPTIONS
+                try
+                {
+                    run(self);
+                }
+                catch(...)
+                {
+                    if(!failed.exchange(true))
+                        error = std::current_exception();
+                }
+#else
+                run(self);
+#endif
+            };
+
+            std::vector<std::thread> pool;
+            pool.reserve(threads - 1);
+            for(unsigned t = 1; t < threads; t++)
+                pool.emplace_back(worker, t);
+            worker(0);
+            for(auto&& thread : pool)
+                thread.join();
+
+            if(error)
+                std::rethrow_exception(error);
+        }
+    }
+
+
+    class ParseResult;
+    struct batch_entry;
+
+
+    /** Command-line to be parsed by Schema::parseBatch
+    */
+    struct command_line
+    {
+        /** Number of arguments, including the program name
+        */
+        int argc;
+
+        /** The arguments
+        */
+        char** argv;
+    };
+
+
+    /** Set of arguments accepted by a program. Arguments
+    *   are registered with addArgument and then compiled by
+    *   freeze(); after that the schema is immutable, and
+    *   its const methods (parse included) can be used by
+    *   any number of threads at the same time, each one
+    *   with its own ParseResult
+    */
+    class Schema
+    {
+        friend class ParseResult;
+
+    protected:
+
+        /** Data structure to describe the basic
+        *   characteristics of an argument
+        *   (hasValue, description)
+        */
+        typedef struct
+        {
+            /** Indicates if the argument is followed
+            *   by a value in command-line. E.g.:
+            *
+            *       program --integer 2
+            *
+            *   The argument "--integer" will contain
+            *   value 2
+            */
+            bool hasValue;
+
+            /** String with the description of the argument.
+            *   It's used to show the usage os the program
+            *   in the terminal
+            */
+            std::string description;
+
+            /** Handle of the argument (its index
+            *   in registration order)
+            */
+            ArgHandle handle;
+
+            /** Variable bound to the argument, or nullptr
+            */
+            void* destination;
+
+            /** Converts the value into destination
+            */
+            detail::store_function store;
+
+            /** Number of values taken
+            */
+            arity values;
+
+            /** Indicates if the argument is positional,
+            *   given by its place instead of its name
+            */
+            bool positional;
+        } argument_data;
+
+        /** map of the arguments registered in the class instance.
+        *   The transparent comparator allows lookups by
+        *   std::string_view without building a temporary string
+        */
+        std::map<std::string, argument_data, std::less<>> _argumentList;
+
+        /** Entry of the frozen index: a flat copy of the
+        *   data needed to classify a token, with the hash
+        *   of the name precomputed
+        */
+        typedef struct
+        {
+            /** Name of the argument (view of the key
+            *   in _argumentList)
+            */
+            std::string_view name;
+
+            /** detail::hashName of the name
+            */
+            std::uint64_t hash;
+
+            /** Same as argument_data::hasValue
+            */
+            bool hasValue;
+
+            /** Same as argument_data::destination
+            */
+            void* destination;
+
+            /** Same as argument_data::store
+            */
+            detail::store_function store;
+
+            /** Same as argument_data::values
+            */
+            arity values;
+
+            /** Index of the argument among the ones keeping
+            *   a list of values, or -1
+            */
+            std::int32_t list;
+
+            /** Same as argument_data::positional
+            */
+            bool positional;
+        } frozen_argument;
+
+        /** Read-only index built by freeze(): the arguments
+        *   stored contiguously, indexed by their handles
+        */
+        std::vector<frozen_argument> _frozenArguments;
+
+        /** Open-addressing (linear probing) hash table over
+        *   _frozenArguments, holding (index + 1) of the
+        *   argument in each slot, or 0 when empty
+        */
+        std::vector<std::uint32_t> _frozenTable;
+
+        /** Pre-filter of the tokens that can be names
+        */
+        detail::name_filter _frozenFilter;
+
+        /** Handles of the short options (-c), indexed by
+        *   the ASCII character, or -1
+        */
+        std::array<std::int32_t, 128> _shortOptions;
+
+        /** Handles of the arguments sorted by name, used
+        *   to find the names starting with a prefix
+        */
+        std::vector<std::uint32_t> _sortedArguments;
+
+        /** Number of arguments keeping a list of values
+        */
+        std::uint32_t _listCount;
+
+        /** Names of the positional arguments, in the
+        *   order they are filled
+        */
+        std::vector<std::string> _positionalNames;
+
+        /** Handles of the positional arguments, in the
+        *   order they are filled, built by freeze()
+        */
+        std::vector<std::uint32_t> _positionals;
+
+        /** A subcommand (as in git commit), whose schema
+        *   is built the first time it's selected
+        */
+        typedef struct
+        {
+            std::string name;
+            std::string description;
+
+            /** detail::hashName of the name
+            */
+            std::uint64_t hash;
+
+            /** Registers the arguments of the subcommand
+            */
+            std::function<void(Schema&)> build;
+
+            /** Guards the construction of the schema, so
+            *   parsing from many threads builds it once
+            */
+            std::once_flag built;
+
+            /** Schema of the subcommand, once built
+            */
+            std::unique_ptr<Schema> schema;
+        } subcommand_data;
+
+        /** Subcommands, in the order they were added. They
+        *   are held by pointer, as std::once_flag can't move
+        */
+        std::vector<std::unique_ptr<subcommand_data>> _subcommands;
+
+        /** Open-addressing hash table over _subcommands, like
+        *   _frozenTable, so selecting a subcommand costs the
+        *   same however many there are
+        */
+        std::vector<std::uint32_t> _subcommandTable;
+
+        /** Indicates if the index was built
+        */
+        bool _frozen;
+
+        /** Name of the program, shown in the usage
+        */
+        std::string _programName;
+
+        /** Texts of the usage, copied by freeze() and shared
+        *   with the exceptions thrown by parse
+        */
+        std::shared_ptr<const detail::usage_model> _usageModel;
+
+        /** Indicates if @path tokens are expanded
+        */
+        bool _responseFiles;
+
+        /** Indicates if unknown tokens are passed through,
+        *   instead of failing the parse
+        */
+        bool _passthrough;
+
+        /** Kinds of constraints between arguments
+        */
+        typedef enum {
+            /** All the arguments must be given
+            */
+            REQUIRED=0,
+
+            /** At most one of the arguments can be given
+            */
+            EXCLUSIVE,
+
+            /** All the arguments must be given, if the
+            *   trigger is given
+            */
+            DEPENDENCY,
+
+            /** At least one of the arguments must be given
+            */
+            AT_LEAST_ONE
+        } constraint_kind;
+
+        /** Trigger of the constraints that always apply
+        */
+        static constexpr std::uint32_t NO_TRIGGER = static_cast<std::uint32_t>(-1);
+
+        /** A constraint, as declared
+        */
+        typedef struct
+        {
+            constraint_kind kind;
+
+            /** Argument enabling the constraint, or NO_TRIGGER
+            */
+            std::uint32_t trigger;
+
+            /** Handles of the arguments constrained
+            */
+            std::vector<std::uint32_t> arguments;
+        } constraint_data;
+
+        /** Constraints declared, compiled by freeze()
+        */
+        std::vector<constraint_data> _constraints;
+
+        /** Word of a bitmask over the handles. Only the
+        *   non-zero words of a mask are stored
+        */
+        typedef struct
+        {
+            /** Index of the word (handle / 64)
+            */
+            std::uint32_t word;
+
+            /** Bits of the handles in the word
+            */
+            std::uint64_t bits;
+        } mask_word;
+
+        /** Constraint compiled into a sparse bitmask,
+        *   checked against the defined bitset of a
+        *   ParseResult one word at a time
+        */
+        typedef struct
+        {
+            constraint_kind kind;
+
+            /** Same as constraint_data::trigger
+            */
+            std::uint32_t trigger;
+
+            /** Range of the mask in _constraintMasks
+            */
+            std::uint32_t begin;
+            std::uint32_t end;
+        } frozen_constraint;
+
+        /** Compiled constraints. The required arguments
+        *   are merged into a single mask
+        */
+        std::vector<frozen_constraint> _frozenConstraints;
+
+        /** Masks of the compiled constraints
+        */
+        std::vector<mask_word> _constraintMasks;
+
+        /** State used to parse the argument and
+        *   its values
+        */
+        typedef enum {
+            ARG_NAME=0,
+            ARG_VALUE,
+            ARG_LIST
+        } parse_state;
+
+        /** Progress of a parse, carried from a token
+        *   to the next
+        */
+        typedef struct
+        {
+            /** Current state
+            */
+            parse_state state;
+
+            /** Argument waiting for its value, while
+            *   state is ARG_VALUE
+            */
+            int pendingArgument;
+
+            /** Indicates if the -- terminator was found, so
+            *   the next tokens are operands
+            */
+            bool operands;
+
+            /** Index in argv of the argument waiting for
+            *   its value
+            */
+            int pendingIndex;
+
+            /** Token of the argument waiting for its value
+            */
+            std::string_view pendingToken;
+
+            /** Values already taken by the argument, while
+            *   state is ARG_LIST
+            */
+            std::uint32_t pendingValues;
+
+            /** Index in _positionals of the positional
+            *   argument being filled
+            */
+            std::uint32_t positional;
+
+            /** Values already taken by that positional argument
+            */
+            std::uint32_t positionalValues;
+
+            /** Indicates if the last token was passed through,
+            *   so the next ones not looking like options are
+            *   passed through with it, as its values
+            */
+            bool passing;
+        } parse_progress;
+
+    public:
+
+        /** Creates an empty schema
+        *
+        *   @param programName
+        *       name of the program, shown in the usage
+        */
+        explicit Schema(const std::string& programName = "") :
+            _shortOptions(),
+            _listCount(0),
+            _frozen(false),
+            _programName(programName),
+            _responseFiles(false),
+            _passthrough(false)
+        {
+        }
+
+        /** Copies the arguments of another schema. The
+        *   frozen index points into the registered names,
+        *   so it's rebuilt for the copy
+        */
+        Schema(const Schema& other) :
+            _argumentList(other._argumentList),
+            _shortOptions(),
+            _listCount(0),
+            _positionalNames(other._positionalNames),
+            _frozen(false),
+            _programName(other._programName),
+            _responseFiles(other._responseFiles),
+            _passthrough(other._passthrough),
+            _constraints(other._constraints)
+        {
+            // Only the registrations are copied: the copy
+            // builds its own subcommand schemas
+            for(auto&& subcommand : other._subcommands)
+                this->addSubcommand(subcommand->name, subcommand->build, subcommand->description);
+
+            if(other._frozen)
+                this->freeze();
+        }
+
+        Schema(Schema&& other) = default;
+
+        /** Copies the arguments of another schema
+        */
+        Schema& operator=(const Schema& other)
+        {
+            if(this != &other)
+            {
+                Schema copy(other);
+                *this = std::move(copy);
+            }
+            return *this;
+        }
+
+        Schema& operator=(Schema&& other) = default;
+
+
+        /** Includes a new expected command-line
+        *   argument to the map, and gives more information
+        *   about what is expected from it
+        *
+        *   @param name
+        *       defines the name of the argument. If you need
+        *       the two dashes (--) as prefix to be expected
+        *       in the command-line you'll have to include it
+        *       in the name.
+        *
+        *       E.g.: program --debug (addArgument("--debug"))
+        *
+        *   @param hasValue
+        *       defines if the arguments receives an actual
+        *       value, or if its just a command-line flag.
+        *       If it has a value, the next argument in the
+        *       list will be taken as the value, otherwise
+        *       the value will be considered empty
+        *
+        *   @param description
+        *       defines the description of the argument. Used
+        *       to be shown to the user as instruction in case
+        *       the "--help" flag is used
+        *
+        *   @return the handle of the argument, to access the
+        *       results without looking up the name. Adding
+        *       the same name again updates the argument and
+        *       returns the same handle
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen
+        */
+        ArgHandle addArgument(
+            const std::string& name,
+            bool hasValue = false,
+            const std::string& description = "")
+        {
+            return this->registerArgument(name, arity::exactly(hasValue ? 1 : 0),
+                description, nullptr, nullptr);
+        }
+
+        /** Includes a new expected command-line argument,
+        *   taking a number of values. They are kept in a
+        *   single buffer shared by all the arguments of the
+        *   ParseResult, and read with ParseResult::values.
+        *   E.g.:
+        *
+        *       program --files a.txt b.txt -I include -I src
+        *
+        *       schema.addArgument("--files", parser::arity::oneOrMore());
+        *       schema.addArgument("-I", parser::arity::repeated());
+        *
+        *   @param name
+        *       defines the name of the argument
+        *
+        *   @param values
+        *       number of values taken
+        *
+        *   @param description
+        *       defines the description of the argument
+        *
+        *   @return the handle of the argument
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen
+        */
+        ArgHandle addArgument(
+            const std::string& name,
+            arity values,
+            const std::string& description = "")
+        {
+            return this->registerArgument(name, values, description, nullptr, nullptr);
+        }
+
+        /** Includes a positional argument: instead of being
+        *   named, it's given by its place among the tokens
+        *   that aren't arguments, which can come between the
+        *   named ones. The positional arguments are filled in
+        *   the order they are added, each one up to its
+        *   maximum of values, so only the last one should
+        *   take an unbounded number. E.g.:
+        *
+        *       program --fast in.dat out.dat extra1 extra2
+        *
+        *       schema.addArgument("--fast");
+        *       schema.addPositional("input");
+        *       schema.addPositional("output");
+        *       schema.addPositional("extras", parser::arity::any());
+        *
+        *   Parsing fails with parse_errc::missing_argument if
+        *   one doesn't get its minimum of values, so the
+        *   positional arguments are required unless their
+        *   arity says otherwise (e.g. parser::arity::optional()).
+        *   Tokens after -- are always positional
+        *
+        *   @param name
+        *       name of the argument, shown in the usage and
+        *       used to access the results. It's never matched
+        *       against the tokens
+        *
+        *   @param values
+        *       number of values taken
+        *
+        *   @param description
+        *       defines the description of the argument
+        *
+        *   @return the handle of the argument
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen
+        */
+        ArgHandle addPositional(
+            const std::string& name,
+            arity values,
+            const std::string& description = "")
+        {
+            return this->registerArgument(name, values, description, nullptr, nullptr, true);
+        }
+
+        /** Includes a subcommand, selected by the first
+        *   positional token (as in git commit). Its arguments
+        *   are registered by a callback that only runs when
+        *   the subcommand is selected, so a program with many
+        *   of them only pays for the one used. E.g.:
+        *
+        *       schema.addSubcommand("commit", [](parser::Schema& commit)
+        *       {
+        *           commit.addArgument("--message", true, "Commit message");
+        *       }, "Record changes");
+        *
+        *   The tokens after the subcommand are parsed by its
+        *   schema, into ParseResult::subcommandResult(). The
+        *   callback may be called from any thread parsing,
+        *   but only once
+        *
+        *   @param name
+        *       name of the subcommand
+        *
+        *   @param build
+        *       callback receiving the empty schema of the
+        *       subcommand, which is frozen after it returns
+        *
+        *   @param description
+        *       defines the description of the subcommand
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen
+        */
+        void addSubcommand(
+            const std::string& name,
+            std::function<void(Schema&)> build,
+            const std::string& description = "")
+        {
+            if(this->_frozen)
+                SIMPLE_ARG_PARSER_THROW(std::logic_error("Schema can't be changed after freeze() or parse()"));
+
+            auto subcommand = std::make_unique<subcommand_data>();
+            subcommand->name = name;
+            subcommand->description = description;
+            subcommand->hash = detail::hashName(name);
+            subcommand->build = std::move(build);
+
+            for(auto&& existing : this->_subcommands)
+                if(existing->name == name)
+                {
+                    existing = std::move(subcommand);
+                    return;
+                }
+            this->_subcommands.push_back(std::move(subcommand));
+        }
+
+        /** Includes a positional argument taking a
+        *   single value. See addPositional
+        */
+        ArgHandle addPositional(
+            const std::string& name,
+            const std::string& description = "")
+        {
+            return this->addPositional(name, arity::exactly(1), description);
+        }
+
+        /** Includes a new expected command-line argument,
+        *   bound to a variable. The value is converted once,
+        *   during parse(), straight into the variable, which
+        *   is left untouched if the argument isn't given.
+        *   A bool variable makes the argument a flag, set to
+        *   true when given; any other type makes it take a
+        *   value, converted by parser::convert. E.g.:
+        *
+        *       int size = 10;
+        *       schema.addArgument("--size", &size, "Size of the vector");
+        *
+        *   The schema never writes to the variables: the
+        *   values are checked while parsing and written by
+        *   ParseResult::store once the parse succeeded (which
+        *   ArgumentParser does by itself), so a failed parse
+        *   leaves them untouched.
+        *
+        *   @param name
+        *       defines the name of the argument
+        *
+        *   @param destination
+        *       variable receiving the value. It must outlive
+        *       the schema
+        *
+        *   @param description
+        *       defines the description of the argument
+        *
+        *   @return the handle of the argument
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen
+        */
+        template <typename T>
+        ArgHandle addArgument(
+            const std::string& name,
+            T* destination,
+            const std::string& description = "")
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                return this->registerArgument(name, arity::exactly(0), description,
+                    destination, &detail::storeFlag);
+            else
+                return this->registerArgument(name, arity::exactly(1), description,
+                    destination, &detail::storeValue<T>);
+        }
+
+        /** Compiles the registered arguments into a read-only
+        *   flat index: an array indexed by the handles plus an
+        *   open-addressing hash table with the precomputed
+        *   hashes, so classifying a token doesn't walk the
+        *   nodes of the map. No argument can be added after it
+        */
+        void freeze()
+        {
+            if(this->_frozen)
+                return;
+
+            this->_frozenArguments.resize(this->_argumentList.size());
+            this->_sortedArguments.clear();
+            this->_sortedArguments.reserve(this->_argumentList.size());
+            this->_frozenFilter = detail::name_filter();
+            this->_shortOptions.fill(-1);
+            this->_listCount = 0;
+            for(auto&& arg : this->_argumentList)
+            {
+                this->_frozenArguments[arg.second.handle.index] = {
+                    arg.first,
+                    detail::hashName(arg.first),
+                    arg.second.hasValue,
+                    arg.second.destination,
+                    arg.second.store,
+                    arg.second.values,
+                    arg.second.values.isList()
+                        ? static_cast<std::int32_t>(this->_listCount++) : -1,
+                    arg.second.positional };
+
+                // Positional arguments are never looked up by name
+                if(arg.second.positional)
+                    continue;
+
+                this->_sortedArguments.push_back(arg.second.handle.index);
+                this->_frozenFilter.add(arg.first);
+                if(arg.first.size() == 2 && arg.first[0] == '-' && arg.first[1] != '-' &&
+                   static_cast<unsigned char>(arg.first[1]) < 128)
+                    this->_shortOptions[static_cast<unsigned char>(arg.first[1])] =
+                        static_cast<std::int32_t>(arg.second.handle.index);
+            }
+
+            this->_positionals.clear();
+            for(auto&& name : this->_positionalNames)
+                this->_positionals.push_back(this->_argumentList.find(name)->second.handle.index);
+
+            this->_frozenTable.assign(
+                detail::tableSizeFor(this->_frozenArguments.size()), 0);
+            std::size_t mask = this->_frozenTable.size() - 1;
+            for(std::size_t i = 0; i < this->_frozenArguments.size(); i++)
+            {
+                if(this->_frozenArguments[i].positional)
+                    continue;
+
+                std::size_t slot = this->_frozenArguments[i].hash & mask;
+                while(this->_frozenTable[slot] != 0)
+                    slot = (slot + 1) & mask;
+                this->_frozenTable[slot] = static_cast<std::uint32_t>(i + 1);
+            }
+
+            this->_subcommandTable.clear();
+            if(!this->_subcommands.empty())
+            {
+                this->_subcommandTable.assign(detail::tableSizeFor(this->_subcommands.size()), 0);
+                mask = this->_subcommandTable.size() - 1;
+                for(std::size_t i = 0; i < this->_subcommands.size(); i++)
+                {
+                    std::size_t slot = this->_subcommands[i]->hash & mask;
+                    while(this->_subcommandTable[slot] != 0)
+                        slot = (slot + 1) & mask;
+                    this->_subcommandTable[slot] = static_cast<std::uint32_t>(i + 1);
+                }
+            }
+
+            this->compileConstraints();
+            this->_usageModel = std::make_shared<detail::usage_model>(
+                this->_programName, [this](auto&& visitor)
+                {
+                    this->visitArguments(visitor);
+                });
+            this->_frozen = true;
+        }
+
+        /** Indicates if the schema was frozen
+        */
+        bool isFrozen() const
+        {
+            return this->_frozen;
+        }
+
+        /** Texts of the usage, shared with the exceptions
+        *   thrown by parse so they render it only when asked
+        *   (nullptr until frozen)
+        */
+        std::shared_ptr<const detail::usage_model> usageModel() const
+        {
+            return this->_usageModel;
+        }
+
+        /** Enables (or disables) the expansion of response
+        *   files: each token like @path is replaced by the
+        *   tokens in the file, as if they were given in
+        *   the command-line. The file is mapped in memory
+        *   and split in place, so its tokens are views into
+        *   the mapping (kept alive by the ParseResult) and
+        *   are not copied. Tokens starting with @ inside a
+        *   response file are not expanded
+        *
+        *   @param enable
+        *       whether @path tokens should be expanded
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen
+        */
+        void enableResponseFiles(bool enable = true)
+        {
+            if(this->_frozen)
+                SIMPLE_ARG_PARSER_THROW(std::logic_error("Schema can't be changed after freeze() or parse()"));
+            this->_responseFiles = enable;
+        }
+
+        /** Enables (or disables) the passthrough of unknown
+        *   tokens: instead of failing the parse, the tokens
+        *   of argv that aren't arguments are recorded, in
+        *   order, as ranges of argv in
+        *   ParseResult::passthrough(), to be forwarded to
+        *   another program. The tokens after an unknown
+        *   option that don't look like options (don't start
+        *   with a dash) are taken as its values and passed
+        *   through with it (unless its value is inline, as
+        *   in --foo=bar), so positional arguments should
+        *   come before it. Tokens inside response files are
+        *   never passed through
+        *
+        *   @param enable
+        *       whether unknown tokens are passed through
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen
+        */
+        void enablePassthrough(bool enable = true)
+        {
+            if(this->_frozen)
+                SIMPLE_ARG_PARSER_THROW(std::logic_error("Schema can't be changed after freeze() or parse()"));
+            this->_passthrough = enable;
+        }
+
+        /** Makes an argument required: parsing fails with
+        *   parse_errc::missing_argument if it's not given.
+        *   The constraints are compiled by freeze() into
+        *   bitmasks, checked at the end of each parse
+        *
+        *   @param argument
+        *       handle of the argument
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen, or the
+        *       handle is unknown
+        */
+        void addRequired(ArgHandle argument)
+        {
+            this->addConstraint(REQUIRED, NO_TRIGGER, { argument });
+        }
+
+        /** Makes arguments mutually exclusive: parsing fails
+        *   with parse_errc::excluded_argument if more than
+        *   one of them is given
+        *
+        *   @param arguments
+        *       handles of the arguments
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen, or a
+        *       handle is unknown
+        */
+        void addExclusive(std::initializer_list<ArgHandle> arguments)
+        {
+            this->addConstraint(EXCLUSIVE, NO_TRIGGER, arguments);
+        }
+
+        /** Makes an argument depend on another: parsing
+        *   fails with parse_errc::missing_dependency if the
+        *   argument is given without its dependency
+        *
+        *   @param argument
+        *       handle of the dependent argument
+        *
+        *   @param dependency
+        *       handle of the argument it needs
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen, or a
+        *       handle is unknown
+        */
+        void addDependency(ArgHandle argument, ArgHandle dependency)
+        {
+            if(argument.index >= this->_argumentList.size())
+                SIMPLE_ARG_PARSER_THROW(std::logic_error("Unknown argument in constraint"));
+            this->addConstraint(DEPENDENCY, argument.index, { dependency });
+        }
+
+        /** Requires at least one of a group of arguments:
+        *   parsing fails with parse_errc::missing_alternative
+        *   if none of them is given
+        *
+        *   @param arguments
+        *       handles of the arguments
+        *
+        *   @throws std::logic_error
+        *       if the schema was already frozen, or a
+        *       handle is unknown
+        */
+        void addAtLeastOne(std::initializer_list<ArgHandle> arguments)
+        {
+            this->addConstraint(AT_LEAST_ONE, NO_TRIGGER, arguments);
+        }
+
+        /** Number of registered arguments
+        */
+        std::size_t size() const
+        {
+            return this->_argumentList.size();
+        }
+
+        /** Name of a registered argument. The schema
+        *   must be frozen
+        *
+        *   @param [in] handle
+        *       handle of the argument
+        */
+        std::string_view name(ArgHandle handle) const
+        {
+            return this->_frozenArguments[handle.index].name;
+        }
+
+        /** Indicates if a registered argument is followed
+        *   by a value. The schema must be frozen
+        *
+        *   @param [in] handle
+        *       handle of the argument
+        */
+        bool takesValue(ArgHandle handle) const
+        {
+            return this->_frozenArguments[handle.index].hasValue;
+        }
+
+        /** Finds an argument in the frozen index
+        *
+        *   @param [in] argName
+        *       name of the argument
+        *
+        *   @return index of the argument (its handle), or -1
+        *       if it's unknown (or not frozen yet)
+        */
+        int findArgument(std::string_view argName) const
+        {
+            if(!this->_frozen || !this->_frozenFilter.mayContain(argName))
+                return -1;
+
+            std::uint64_t hash = detail::hashName(argName);
+            std::size_t mask = this->_frozenTable.size() - 1;
+            for(std::size_t slot = hash & mask;; slot = (slot + 1) & mask)
+            {
+                std::uint32_t item = this->_frozenTable[slot];
+                if(item == 0)
+                    return -1;
+
+                auto&& argument = this->_frozenArguments[item - 1];
+                if(argument.hash == hash && argument.name == argName)
+                    return static_cast<int>(item - 1);
+            }
+        }
+
+        /** Finds a positional argument by its name
+        *
+        *   @param [in] argName
+        *       name of the argument
+        *
+        *   @return index of the argument (its handle), or -1
+        *       if it's unknown (or not frozen yet)
+        */
+        int findPositional(std::string_view argName) const
+        {
+            for(auto argument : this->_positionals)
+                if(this->_frozenArguments[argument].name == argName)
+                    return static_cast<int>(argument);
+            return -1;
+        }
+
+        /** Finds a subcommand in the frozen index
+        *
+        *   @param [in] name
+        *       name of the subcommand
+        *
+        *   @return index of the subcommand, or -1 if it's
+        *       unknown (or not frozen yet)
+        */
+        int findSubcommand(std::string_view name) const
+        {
+            if(this->_subcommandTable.empty())
+                return -1;
+
+            std::uint64_t hash = detail::hashName(name);
+            std::size_t mask = this->_subcommandTable.size() - 1;
+            for(std::size_t slot = hash & mask;; slot = (slot + 1) & mask)
+            {
+                std::uint32_t item = this->_subcommandTable[slot];
+                if(item == 0)
+                    return -1;
+
+                auto&& subcommand = *this->_subcommands[item - 1];
+                if(subcommand.hash == hash && subcommand.name == name)
+                    return static_cast<int>(item - 1);
+            }
+        }
+
+        /** Schema of a subcommand, built (and frozen) the
+        *   first time it's needed. The schema must be frozen
+        *
+        *   @param [in] name
+        *       name of the subcommand
+        *
+        *   @return the schema, or nullptr if there's no
+        *       such subcommand
+        */
+        const Schema* subcommand(std::string_view name) const
+        {
+            int index = this->findSubcommand(name);
+            if(index < 0)
+                return nullptr;
+            return &this->subcommandSchema(static_cast<std::size_t>(index));
+        }
+
+        /** Returns the instructions of the program
+        *
+        *   @param [in] programName
+        *       name of the program. If empty, the name
+        *       given in the constructor is used
+        */
+        std::string usage(std::string_view programName = std::string_view()) const
+        {
+            if(programName.empty())
+                programName = this->_programName;
+
+            return detail::usageText(programName, [this](auto&& visitor)
+            {
+                this->visitArguments(visitor);
+            });
+        }
+
+        /** Writes the instructions of the program straight
+        *   to a sink, wrapped to a number of columns. Nothing
+        *   is allocated, however many arguments there are
+        *   (unless the sink is a std::string). E.g.:
+        *
+        *       schema.writeUsage(stderr);
+        *
+        *   @param sink
+        *       destination of the text (a std::ostream,
+        *       FILE*, std::string or caller buffer)
+        *
+        *   @param [in] width
+        *       number of columns, by default the width of
+        *       the terminal the sink writes to (80 if it
+        *       isn't a terminal). 0 gives the same text as
+        *       usage()
+        *
+        *   @param [in] programName
+        *       name of the program. If empty, the name
+        *       given in the constructor is used
+        *
+        *   @return length of the text (it may be larger
+        *       than a buffer given as sink)
+        */
+        std::size_t writeUsage(
+            output_sink&& sink,
+            std::size_t width = output_sink::TERMINAL_WIDTH,
+            std::string_view programName = std::string_view()) const
+        {
+            if(programName.empty())
+                programName = this->_programName;
+
+            detail::writeUsageText(sink, programName, width, [this](auto&& visitor)
+            {
+                this->visitArguments(visitor);
+            });
+            sink.flush();
+            return sink.written();
+        }
+
+        /** Visits the names starting with a prefix, in
+        *   alphabetical order. It's a binary search in the
+        *   frozen index, so it costs the same for a handful
+        *   or thousands of arguments. The schema must be
+        *   frozen
+        *
+        *   @param [in] prefix
+        *       beginning of the names
+        *
+        *   @param visitor
+        *       callable receiving each name
+        */
+        template <typename Visitor>
+        void completions(std::string_view prefix, Visitor visitor) const
+        {
+            auto first = std::lower_bound(
+                this->_sortedArguments.begin(), this->_sortedArguments.end(), prefix,
+                [this](std::uint32_t handle, std::string_view prefix)
+                {
+                    return this->_frozenArguments[handle].name < prefix;
+                });
+
+            for(auto item = first; item != this->_sortedArguments.end(); ++item)
+            {
+                std::string_view name = this->_frozenArguments[*item].name;
+                if(name.substr(0, prefix.size()) != prefix)
+                    break;
+                visitor(name);
+            }
+        }
+
+        /** Answers a shell completion request, made by
+        *   running the program as:
+        *
+        *       program __complete <cword> <words...>
+        *
+        *   The names (and subcommands) starting with
+        *   words[cword] are written one per line, or nothing
+        *   if the word is the value of an argument. After a
+        *   subcommand, its own schema answers. Call it before
+        *   parse(), and exit if it returns true. The schema
+        *   must be frozen
+        *
+        *   @param argc, argv
+        *       the input received by main
+        *
+        *   @param out
+        *       stream receiving the candidates
+        *
+        *   @return false if the input isn't a completion
+        *       request
+        */
+        bool handleCompletion(int argc, char** argv, std::ostream& out = std::cout) const
+        {
+            auto takesValue = [this](std::string_view name)
+            {
+                int argument = this->findArgument(name);
+                return argument >= 0 && this->_frozenArguments[argument].hasValue;
+            };
+
+            // A subcommand before the word being completed
+            // answers for the rest of the words
+            if(!this->_subcommandTable.empty() && argc >= 4 && std::string_view(argv[1]) == "__complete")
+            {
+                int cword = std::atoi(argv[2]);
+                int words = argc - 3;
+                for(int i = 1; i < cword && i < words; i++)
+                {
+                    std::string_view word(argv[3 + i]);
+                    if(!word.empty() && word[0] == '-')
+                    {
+                        if(takesValue(word))
+                            i++;
+                        continue;
+                    }
+
+                    int subcommand = this->findSubcommand(word);
+                    if(subcommand < 0)
+                        break;
+
+                    std::string subCword = std::to_string(cword - i);
+                    std::vector<char*> subArgv = { argv[0], argv[1], &subCword[0] };
+                    subArgv.insert(subArgv.end(), argv + 3 + i, argv + argc);
+                    return this->subcommandSchema(static_cast<std::size_t>(subcommand)).handleCompletion(
+                        static_cast<int>(subArgv.size()), subArgv.data(), out);
+                }
+            }
+
+            return detail::answerCompletion(argc, argv, out, takesValue,
+                [this](std::string_view prefix, auto&& visitor)
+                {
+                    this->completions(prefix, visitor);
+                    for(auto&& subcommand : this->_subcommands)
+                        if(std::string_view(subcommand->name).substr(0, prefix.size()) == prefix)
+                            visitor(subcommand->name);
+                });
+        }
+
+        /** Writes a bash or zsh completion script, which
+        *   asks the program for the candidates through
+        *   handleCompletion. E.g.:
+        *
+        *       program --completion-script > /etc/bash_completion.d/program
+        *
+        *   @param out
+        *       stream receiving the script
+        *
+        *   @param shell
+        *       shell running the script
+        *
+        *   @param programName
+        *       name of the program. If empty, the name
+        *       given in the constructor is used
+        */
+        void writeCompletionScript(
+            std::ostream& out,
+            completion_shell shell = completion_shell::bash,
+            std::string_view programName = std::string_view()) const
+        {
+            if(programName.empty())
+                programName = this->_programName;
+
+            detail::writeCompletionScript(out, shell, programName);
+        }
+
+        /** Parses the raw command-line input into a new
+        *   result. The values are not copied: they point
+        *   into argv, which must outlive the result.
+        *
+        *   @param argc
+        *       the same argc received as inputs to main
+        *
+        *   @param argv
+        *       the argv received from main
+        *
+        *   @throws parser::parsing_exception
+        *       if an argument is not expected, or a
+        *       response file can't be used. The exception
+        *       refers to this schema
+        *
+        *   @throws std::logic_error
+        *       if the schema is not frozen
+        */
+        ParseResult parse(int argc, char** argv) const;
+
+        /** Parses the raw command-line input, adding the
+        *   arguments found to an existing result (arguments
+        *   given again are overwritten).
+        *
+        *   @param argc
+        *       the same argc received as inputs to main
+        *
+        *   @param argv
+        *       the argv received from main
+        *
+        *   @param result
+        *       result to be updated. If it belongs to
+        *       another schema, it's cleared first. To reuse
+        *       a result for a new input, call its clear():
+        *       once it has the right size, parsing into it
+        *       does no allocation
+        *
+        *   @throws parser::parsing_exception
+        *       if an argument is not expected, or a
+        *       response file can't be used
+        *
+        *   @throws std::logic_error
+        *       if the schema is not frozen
+        */
+        void parse(int argc, char** argv, ParseResult& result) const;
+
+        /** Parses many command-lines at once, in parallel.
+        *   Nothing is thrown for invalid command-lines: each
+        *   one gets its own result and status, in the same
+        *   order of the input.
+        *
+        *   @param lines
+        *       command-lines to be parsed. They must outlive
+        *       the results
+        *
+        *   @param count
+        *       number of command-lines
+        *
+        *   @param threads
+        *       maximum number of threads, or 0 to use
+        *       one per hardware thread
+        *
+        *   @throws std::logic_error
+        *       if the schema is not frozen
+        */
+        std::vector<batch_entry> parseBatch(
+            const command_line* lines,
+            std::size_t count,
+            unsigned threads = 0) const;
+
+        /** Parses many command-lines at once, in parallel.
+        *   See parseBatch(lines, count, threads)
+        *
+        *   @param lines
+        *       command-lines to be parsed
+        *
+        *   @param threads
+        *       maximum number of threads, or 0 to use
+        *       one per hardware thread
+        */
+        std::vector<batch_entry> parseBatch(
+            const std::vector<command_line>& lines,
+            unsigned threads = 0) const;
+
+        /** Parses the raw command-line input, adding the
+        *   arguments found to an existing result, without
+        *   throwing: errors are returned instead. It's the
+        *   core of the parse methods, which just throw the
+        *   errors it finds, and the way to parse when most
+        *   inputs are invalid, or without exceptions. E.g.:
+        *
+        *       parser::ParseResult result;
+        *       parser::parse_status status = schema.tryParse(argc, argv, result);
+        *       if(!status)
+        *           std::cerr << "Bad argument " << status.token << std::endl;
+        *
+        *   @param argc
+        *       number of arguments, including the
+        *       program name
+        *
+        *   @param argv
+        *       the arguments. The values point into it, so
+        *       it must outlive the result
+        *
+        *   @param result
+        *       result to be updated. Arguments found before
+        *       an error are kept
+        *
+        *   @return the outcome of the parse. On errors, it
+        *       holds the code, the index of the offending
+        *       token in argv and the token itself
+        *
+        *   @throws std::logic_error
+        *       if the schema is not frozen
+        */
+        parse_status tryParse(int argc, char** argv, ParseResult& result) const;
+
+    protected:
+
+        /** Registers an argument. See addArgument
+        */
+        ArgHandle registerArgument(
+            const std::string& name,
+            arity values,
+            const std::string& description,
+            void* destination,
+            detail::store_function store,
+            bool positional = false)
+        {
+            if(this->_frozen)
+                SIMPLE_ARG_PARSER_THROW(std::logic_error("Arguments can't be added after freeze() or parse()"));
+
+            LOG("New Argument");
+            ArgHandle handle = { static_cast<std::uint32_t>(this->_argumentList.size()) };
+            auto argument = this->_argumentList.find(name);
+            if(argument != this->_argumentList.end())
+                handle = argument->second.handle;
+
+            argument_data argData = { values.maximum > 0, description, handle, destination, store, values, positional };
+            LOG_VAR(argData.hasValue);
+            LOG_VAR(argData.description);
+            this->_argumentList[name] = argData;
+
+            auto position = std::find(this->_positionalNames.begin(), this->_positionalNames.end(), name);
+            if(positional && position == this->_positionalNames.end())
+                this->_positionalNames.push_back(name);
+            else if(!positional && position != this->_positionalNames.end())
+                this->_positionalNames.erase(position);
+
+            return handle;
+        }
+
+        /** Visits the named arguments, in alphabetical
+        *   order, then the positional ones and the
+        *   subcommands, in order, as
+        *   visitor(name, hasValue, description)
+        */
+        template <typename Visitor>
+        void visitArguments(Visitor&& visitor, bool positionals = true) const
+        {
+            for(auto&& arg : this->_argumentList)
+                if(!arg.second.positional)
+                    visitor(arg.first, arg.second.hasValue, arg.second.description);
+            if(positionals)
+                for(auto&& name : this->_positionalNames)
+                    visitor(name, false, this->_argumentList.find(name)->second.description);
+            for(auto&& subcommand : this->_subcommands)
+                visitor(subcommand->name, false, subcommand->description);
+        }
+
+        /** Schema of a subcommand, built on first use
+        *
+        *   @param index
+        *       index of the subcommand in _subcommands
+        */
+        const Schema& subcommandSchema(std::size_t index) const
+        {
+            subcommand_data& subcommand = *this->_subcommands[index];
+            std::call_once(subcommand.built, [this, &subcommand]
+            {
+                auto schema = std::make_unique<Schema>(this->_programName + " " + subcommand.name);
+                subcommand.build(*schema);
+                schema->freeze();
+                subcommand.schema = std::move(schema);
+            });
+            return *subcommand.schema;
+        }
+
+        /** Declares a constraint. See addRequired
+        */
+        void addConstraint(
+            constraint_kind kind,
+            std::uint32_t trigger,
+            std::initializer_list<ArgHandle> arguments)
+        {
+            if(this->_frozen)
+                SIMPLE_ARG_PARSER_THROW(std::logic_error("Schema can't be changed after freeze() or parse()"));
+
+            constraint_data constraint = { kind, trigger, {} };
+            for(auto&& argument : arguments)
+            {
+                if(argument.index >= this->_argumentList.size())
+                    SIMPLE_ARG_PARSER_THROW(std::logic_error("Unknown argument in constraint"));
+                constraint.arguments.push_back(argument.index);
+            }
+            this->_constraints.push_back(std::move(constraint));
+        }
+
+        /** Compiles a set of handles into a sparse mask at
+        *   the end of _constraintMasks
+        */
+        void compileMask(
+            constraint_kind kind,
+            std::uint32_t trigger,
+            std::vector<std::uint32_t> arguments)
+        {
+            std::sort(arguments.begin(), arguments.end());
+            std::uint32_t begin = static_cast<std::uint32_t>(this->_constraintMasks.size());
+            for(auto argument : arguments)
+            {
+                std::uint32_t word = argument >> 6;
+                std::uint64_t bit = std::uint64_t(1) << (argument & 63);
+                if(this->_constraintMasks.size() > begin && this->_constraintMasks.back().word == word)
+                    this->_constraintMasks.back().bits |= bit;
+                else
+                    this->_constraintMasks.push_back({ word, bit });
+            }
+            this->_frozenConstraints.push_back({ kind, trigger, begin,
+                static_cast<std::uint32_t>(this->_constraintMasks.size()) });
+        }
+
+        /** Compiles the declared constraints into masks
+        */
+        void compileConstraints()
+        {
+            this->_frozenConstraints.clear();
+            this->_constraintMasks.clear();
+
+            std::vector<std::uint32_t> required;
+            for(auto&& constraint : this->_constraints)
+            {
+                if(constraint.kind == REQUIRED)
+                    required.insert(required.end(), constraint.arguments.begin(), constraint.arguments.end());
+                else
+                    this->compileMask(constraint.kind, constraint.trigger, constraint.arguments);
+            }
+            if(!required.empty())
+                this->compileMask(REQUIRED, NO_TRIGGER, std::move(required));
+        }
+
+        /** Checks the compiled constraints against the
+        *   arguments found, a word of 64 arguments at a time
+        *
+        *   @param result
+        *       arguments found
+        */
+        parse_status checkConstraints(const ParseResult& result) const;
+
+        /** Runs the parsing state machine for one token
+        *
+        *   @param currentArg
+        *       the token
+        *
+        *   @param _arg
+        *       index of the token in argv
+        *
+        *   @param progress
+        *       state of the parse
+        *
+        *   @param result
+        *       result being filled
+        */
+        parse_status parseToken(
+            std::string_view currentArg,
+            int _arg,
+            parse_progress& progress,
+            ParseResult& result) const;
+
+        /** Parses the GNU forms of a token that isn't the
+        *   exact name of an argument: --name=value, --no-flag,
+        *   -j8, -abc clusters and the -- terminator
+        *
+        *   @param currentArg
+        *       the token
+        *
+        *   @param _arg
+        *       index of the token in argv
+        *
+        *   @param progress
+        *       state of the parse
+        *
+        *   @param result
+        *       result being filled
+        */
+        parse_status parseOptionForms(
+            std::string_view currentArg,
+            int _arg,
+            parse_progress& progress,
+            ParseResult& result) const;
+
+        /** Records an argument found
+        *
+        *   @param argument
+        *       handle of the argument
+        *
+        *   @param value
+        *       its value, when given in the same token
+        *
+        *   @param inlineValue
+        *       indicates if the value was given in the token
+        *
+        *   @param currentArg
+        *       the token
+        *
+        *   @param _arg
+        *       index of the token in argv
+        *
+        *   @param progress
+        *       state of the parse, waiting for the value
+        *       if it's in the next token
+        *
+        *   @param result
+        *       result being filled
+        */
+        parse_status defineArgument(
+            int argument,
+            std::string_view value,
+            bool inlineValue,
+            std::string_view currentArg,
+            int _arg,
+            parse_progress& progress,
+            ParseResult& result) const;
+
+        /** Stores the value of an argument
+        */
+        parse_status defineValue(
+            int argument,
+            std::string_view value,
+            int _arg,
+            ParseResult& result) const;
+
+        /** Gives a token to the positional argument being
+        *   filled, moving to the next one when it's full
+        *
+        *   @return false if there's no positional argument
+        *       left to take it
+        */
+        bool definePositional(
+            std::string_view currentArg,
+            parse_progress& progress,
+            ParseResult& result) const;
+
+        /** Appends a value to the list of the argument
+        *   pending in progress, leaving the ARG_LIST state
+        *   when it has all its values
+        */
+        void appendValue(
+            std::string_view value,
+            parse_progress& progress,
+            ParseResult& result) const;
+
+        /** Finds the argument named prefix + rest, without
+        *   building the name
+        */
+        int findJoined(std::string_view prefix, std::string_view rest) const
+        {
+            if(!this->_frozen)
+                return -1;
+
+            std::uint64_t hash = detail::hashName(rest, detail::hashName(prefix));
+            std::size_t mask = this->_frozenTable.size() - 1;
+            for(std::size_t slot = hash & mask;; slot = (slot + 1) & mask)
+            {
+                std::uint32_t item = this->_frozenTable[slot];
+                if(item == 0)
+                    return -1;
+
+                auto&& argument = this->_frozenArguments[item - 1];
+                if(argument.hash == hash &&
+                   argument.name.size() == prefix.size() + rest.size() &&
+                   argument.name.substr(0, prefix.size()) == prefix &&
+                   argument.name.substr(prefix.size()) == rest)
+                    return static_cast<int>(item - 1);
+            }
+        }
+
+        /** Maps a response file and feeds its tokens to
+        *   the parsing state machine
+        *
+        *   @param currentArg
+        *       the @path token
+        *
+        *   @param _arg
+        *       index of the token in argv
+        *
+        *   @param progress
+        *       state of the parse
+        *
+        *   @param result
+        *       result being filled, which keeps the mapping
+        */
+        parse_status parseResponseFile(
+            std::string_view currentArg,
+            int _arg,
+            parse_progress& progress,
+            ParseResult& result) const;
+    };
+
+
+    /** Arguments found by Schema::parse. Results are
+    *   cheap to create and independent of each other, so
+    *   each thread can parse into its own. The schema must
+    *   outlive the result, and so must the argv parsed (the
+    *   values point into it)
+    */
+    class ParseResult
+    {
+        friend class Schema;
+        friend class ArgumentParser;
+
+    protected:
+        /** Schema used to parse the arguments
+        */
+        const Schema* _schema;
+
+        /** Values of the arguments parsed from the inputs,
+        *   indexed by the handles of the arguments. They are
+        *   views pointing straight into argv (or into a
+        *   response file), so no value is ever copied
+        */
+        std::vector<std::string_view> _parsedValues;
+
+        /** Indicates which arguments were given: a bitset
+        *   indexed by the handles of the arguments, in 64-bit
+        *   words, so the constraints are checked a word at
+        *   a time. It's followed by as many words marking the
+        *   flags negated by --no-flag, kept in the same
+        *   buffer to save an allocation
+        */
+        std::vector<std::uint64_t> _parsedDefined;
+
+        /** Number of times each argument was given,
+        *   indexed by the handles of the arguments
+        */
+        std::vector<std::uint32_t> _parsedCounts;
+
+        /** Tokens after the -- terminator
+        */
+        std::vector<std::string_view> _operands;
+
+        /** Value of an argument keeping a list, tagged
+        *   with the index of the list
+        */
+        typedef struct
+        {
+            std::uint32_t list;
+            std::string_view value;
+        } list_entry;
+
+        /** Values of all the lists, in the order found
+        */
+        std::vector<list_entry> _listEntries;
+
+        /** Position in _listEntries of the last occurrence
+        *   of each list, so a repeated argument that isn't
+        *   repeatable keeps only its last values
+        */
+        std::vector<std::uint32_t> _listStarts;
+
+        /** Values of all the lists, grouped by list at the
+        *   end of the parse
+        */
+        std::vector<std::string_view> _listValues;
+
+        /** Range of each list in _listValues (list i goes
+        *   from _listOffsets[i] to _listOffsets[i + 1])
+        */
+        std::vector<std::uint32_t> _listOffsets;
+
+        /** Tokens of argv passed through, in order
+        */
+        std::vector<argv_range> _passthrough;
+
+        /** Index of the subcommand selected, or -1
+        */
+        int _subcommand;
+
+        /** Result of the subcommand (empty until one is
+        *   selected, then kept to be reused)
+        */
+        std::vector<ParseResult> _subResults;
+
+        /** Response files read by the parse. They are kept
+        *   alive because the values point into them
+        */
+        std::vector<std::shared_ptr<detail::mapped_file>> _mappedFiles;
+
+        /** Binds the result to a schema, with no
+        *   argument defined
+        */
+        void bind(const Schema& schema)
+        {
+            this->_schema = &schema;
+            this->_parsedValues.assign(schema.size(), std::string_view());
+            this->_parsedDefined.assign(2 * ((schema.size() + 63) / 64), 0);
+            this->_parsedCounts.assign(schema.size(), 0);
+            this->_operands.clear();
+            this->_mappedFiles.clear();
+            this->_listEntries.clear();
+            this->_listValues.clear();
+            this->_listStarts.assign(schema._listCount, 0);
+            this->_listOffsets.assign(schema._listCount != 0 ? schema._listCount + 1 : 0, 0);
+            this->_passthrough.clear();
+            this->_subcommand = -1;
+        }
+
+        /** Points the result (and the result of its
+        *   subcommand) to a copy of its schema, whose
+        *   subcommand schemas are built if needed
+        *
+        *   @param schema
+        *       copy of the schema used in the parse
+        */
+        void retarget(const Schema& schema)
+        {
+            this->_schema = &schema;
+            for(std::size_t i = 0; i < this->_subResults.size(); i++)
+            {
+                if(this->_subcommand >= 0)
+                    this->_subResults[i].retarget(
+                        schema.subcommandSchema(static_cast<std::size_t>(this->_subcommand)));
+                else
+                    this->_subResults[i]._schema = nullptr;
+            }
+        }
+
+        /** Passes a token of argv through, extending the
+        *   last range when it's right before it
+        */
+        void passToken(int index)
+        {
+            if(!this->_passthrough.empty() && this->_passthrough.back().end == index)
+                this->_passthrough.back().end++;
+            else
+                this->_passthrough.push_back(argv_range{ index, index + 1 });
+        }
+
+        /** Indicates if the argument of a handle was given
+        */
+        bool defined(std::size_t index) const
+        {
+            return (this->_parsedDefined[index >> 6] >> (index & 63)) & 1;
+        }
+
+        /** Marks the argument of a handle as given
+        */
+        void define(std::size_t index)
+        {
+            this->_parsedDefined[index >> 6] |= std::uint64_t(1) << (index & 63);
+        }
+
+        /** Marks the argument of a handle as not given
+        */
+        void undefine(std::size_t index)
+        {
+            this->_parsedDefined[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+        }
+
+        /** Indicates if the flag of a handle was negated
+        */
+        bool negated(std::size_t index) const
+        {
+            std::size_t words = this->_parsedDefined.size() / 2;
+            return (this->_parsedDefined[words + (index >> 6)] >> (index & 63)) & 1;
+        }
+
+        /** Marks the flag of a handle as negated (and not
+        *   given), so store() clears its bound variable
+        */
+        void negate(std::size_t index)
+        {
+            std::size_t words = this->_parsedDefined.size() / 2;
+            this->undefine(index);
+            this->_parsedDefined[words + (index >> 6)] |= std::uint64_t(1) << (index & 63);
+        }
+
+        /** Groups the values in _listEntries by list into
+        *   _listValues, with a counting sort: a pass to count
+        *   the values of each list and another to place them
+        */
+        void groupLists()
+        {
+            std::size_t lists = this->_listStarts.size();
+            if(lists == 0)
+                return;
+
+            std::fill(this->_listOffsets.begin(), this->_listOffsets.end(), 0);
+            for(std::size_t i = 0; i < this->_listEntries.size(); i++)
+            {
+                auto&& entry = this->_listEntries[i];
+                if(i >= this->_listStarts[entry.list])
+                    this->_listOffsets[entry.list + 1]++;
+            }
+            for(std::size_t list = 1; list <= lists; list++)
+                this->_listOffsets[list] += this->_listOffsets[list - 1];
+
+            // Placing each value moves the offset of its list
+            // to the end of the list, which is the beginning
+            // of the next one, so they are shifted back after
+            this->_listValues.resize(this->_listOffsets[lists]);
+            for(std::size_t i = 0; i < this->_listEntries.size(); i++)
+            {
+                auto&& entry = this->_listEntries[i];
+                if(i >= this->_listStarts[entry.list])
+                    this->_listValues[this->_listOffsets[entry.list]++] = entry.value;
+            }
+            for(std::size_t list = lists; list > 0; list--)
+                this->_listOffsets[list] = this->_listOffsets[list - 1];
+            this->_listOffsets[0] = 0;
+        }
+
+    public:
+
+        /** Creates an empty result, not bound to any schema
+        */
+        ParseResult() :
+            _schema(nullptr),
+            _subcommand(-1)
+        { }
+
+        /** Creates an empty result for a schema
+        *
+        *   @param schema
+        *       schema of the arguments
+        */
+        explicit ParseResult(const Schema& schema) :
+            _schema(nullptr),
+            _subcommand(-1)
+        {
+            this->bind(schema);
+        }
+
+        /** Schema used to parse the arguments, or nullptr
+        */
+        const Schema* schema() const
+        {
+            return this->_schema;
+        }
+
+        /** Writes the values found to the variables bound to
+        *   the arguments (see Schema::addArgument), including
+        *   the ones of the subcommand selected. The values
+        *   were already checked by the parse, so nothing can
+        *   fail here. ArgumentParser calls it after every
+        *   successful parse; with a Schema, call it once the
+        *   parse succeeded:
+        *
+        *       if(schema.tryParse(argc, argv, result))
+        *           result.store();
+        *
+        *   Arguments not given keep the values of their
+        *   variables, and a --no-flag sets its bool to false
+        */
+        void store() const
+        {
+            if(this->_schema == nullptr)
+                return;
+
+            for(std::size_t i = 0; i < this->_parsedValues.size(); i++)
+            {
+                auto&& data = this->_schema->_frozenArguments[i];
+                if(data.store == nullptr)
+                    continue;
+
+                if(this->defined(i))
+                    data.store(this->_parsedValues[i], data.destination);
+                else if(this->negated(i) && data.store == &detail::storeFlag)
+                    *static_cast<bool*>(data.destination) = false;
+            }
+            if(this->_subcommand >= 0)
+                this->_subResults[0].store();
+        }
+
+        /** Forgets all the arguments found, keeping the
+        *   memory already allocated, so the result can be
+        *   reused by Schema::parse without allocating
+        */
+        void clear()
+        {
+            std::fill(this->_parsedDefined.begin(), this->_parsedDefined.end(), 0);
+            std::fill(this->_parsedValues.begin(), this->_parsedValues.end(), std::string_view());
+            std::fill(this->_parsedCounts.begin(), this->_parsedCounts.end(), 0);
+            this->_operands.clear();
+            this->_mappedFiles.clear();
+            this->_listEntries.clear();
+            this->_listValues.clear();
+            std::fill(this->_listStarts.begin(), this->_listStarts.end(), 0);
+            std::fill(this->_listOffsets.begin(), this->_listOffsets.end(), 0);
+            this->_passthrough.clear();
+            this->_subcommand = -1;
+            for(auto&& subResult : this->_subResults)
+                subResult.clear();
+        }
+
+        /** Verifies if a giver argument is defined
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        bool isDefined(ArgHandle handle) const
+        {
+            return handle.index < this->_parsedValues.size()
+                && this->defined(handle.index);
+        }
+
+
+        /** Verifies if a giver argument is defined
+        *
+        *   @param [in] argName
+        *       name of the argument to be verified
+        */
+        bool isDefined(std::string_view argName) const
+        {
+            int argument = this->find(argName);
+            return argument >= 0 && this->defined(argument);
+        }
+
+
+        /** Number of times an argument was given (e.g. 3
+        *   for -vvv). A --no-flag resets it to 0
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        std::size_t count(ArgHandle handle) const
+        {
+            return handle.index < this->_parsedCounts.size()
+                ? this->_parsedCounts[handle.index] : 0;
+        }
+
+
+        /** Number of times an argument was given
+        *
+        *   @param [in] argName
+        *       name of the argument
+        */
+        std::size_t count(std::string_view argName) const
+        {
+            int argument = this->find(argName);
+            return argument >= 0 ? this->_parsedCounts[argument] : 0;
+        }
+
+
+        /** Tokens given after the -- terminator, which
+        *   are never taken as arguments
+        */
+        const std::vector<std::string_view>& operands() const
+        {
+            return this->_operands;
+        }
+
+
+        /** Values of an argument. For an argument taking
+        *   many values (see parser::arity) these are all of
+        *   them, in order; for any other, its value if it
+        *   was given. E.g.:
+        *
+        *       for(std::string_view file : result.values(FILES))
+        *           ...
+        *
+        *   @param handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        value_range values(ArgHandle handle) const
+        {
+            if(this->_schema == nullptr || handle.index >= this->_parsedValues.size())
+                return value_range();
+
+            std::int32_t list = this->_schema->_frozenArguments[handle.index].list;
+            if(list >= 0)
+            {
+                const std::string_view* data = this->_listValues.data();
+                return value_range(data + this->_listOffsets[list], data + this->_listOffsets[list + 1]);
+            }
+
+            const std::string_view* value = &this->_parsedValues[handle.index];
+            if(this->hasValue(handle))
+                return value_range(value, value + 1);
+            return value_range();
+        }
+
+
+        /** Values of an argument
+        *
+        *   @param argName
+        *       name of the argument
+        */
+        value_range values(std::string_view argName) const
+        {
+            int argument = this->find(argName);
+            if(argument < 0)
+                return value_range();
+            return this->values(ArgHandle{ static_cast<std::uint32_t>(argument) });
+        }
+
+
+        /** Tokens of argv passed through (see
+        *   Schema::enablePassthrough), as ranges of argv in
+        *   order. Consecutive tokens are merged into a single
+        *   range, so forwarding them is a copy per range. E.g.:
+        *
+        *       for(auto range : result.passthrough())
+        *           child.insert(child.end(), argv + range.begin, argv + range.end);
+        */
+        const std::vector<argv_range>& passthrough() const
+        {
+            return this->_passthrough;
+        }
+
+
+        /** Name of the subcommand selected, or an empty
+        *   view if none was
+        */
+        std::string_view subcommand() const
+        {
+            if(this->_subcommand < 0)
+                return std::string_view();
+            return this->_schema->_subcommands[this->_subcommand]->name;
+        }
+
+
+        /** Arguments of the subcommand selected, parsed
+        *   by its schema, or nullptr if none was. E.g.:
+        *
+        *       if(result.subcommand() == "commit")
+        *           message = result.subcommandResult()->getArgumentView("--message");
+        */
+        const ParseResult* subcommandResult() const
+        {
+            if(this->_subcommand < 0)
+                return nullptr;
+            return &this->_subResults[0];
+        }
+
+
+        /** Verifies if a given argument constains an extra
+        *   value
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        bool hasValue(ArgHandle handle) const
+        {
+            return this->isDefined(handle)
+                && this->_schema->takesValue(handle);
+        }
+
+
+        /** Verifies if a given argument constains an extra
+        *   value
+        *
+        *   @param [in] argName
+        *       name of the argument to be verified
+        */
+        bool hasValue(std::string_view argName) const
+        {
+            int argument = this->find(argName);
+            return argument >= 0
+                && this->hasValue(ArgHandle{ static_cast<std::uint32_t>(argument) });
+        }
+
+        /** Retrieve the raw argument value without any copy
+        *   or conversion. If the argument was not defined,
+        *   or is a flag with no value, the view is empty
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        std::string_view getArgumentView(ArgHandle handle) const
+        {
+            if(!this->isDefined(handle))
+                return std::string_view();
+            return this->_parsedValues[handle.index];
+        }
+
+        /** Retrieve the raw argument value without any copy
+        *   or conversion. If the argument was not defined,
+        *   or is a flag with no value, the view is empty
+        *
+        *   @param [in] argName
+        *       name of the argument to be retrieved
+        */
+        std::string_view getArgumentView(std::string_view argName) const
+        {
+            int argument = this->find(argName);
+            if(argument < 0)
+                return std::string_view();
+            return this->_parsedValues[argument];
+        }
+
+        /** Retrieve the argument value, converted to T
+        *   by parser::convert
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        *
+        *   @throws parser::conversion_exception
+        *       if the argument was not defined, or if its
+        *       value is malformed or out of range for T
+        */
+        template <typename T>
+        T getArgument(ArgHandle handle) const
+        {
+            bool defined = this->isDefined(handle);
+            bool known = this->_schema != nullptr && handle.index < this->_parsedValues.size();
+            return detail::convertArgument<T>(
+                known ? this->_schema->name(handle) : std::string_view(),
+                defined,
+                defined ? this->_parsedValues[handle.index] : std::string_view());
+        }
+
+        /** Retrieve the argument value, converted to T
+        *   by parser::convert
+        *
+        *   @param [in] argName
+        *       name of the argument to be verified
+        *
+        *   @throws parser::conversion_exception
+        *       if the argument was not defined, or if its
+        *       value is malformed or out of range for T
+        */
+        template <typename T>
+        T getArgument(std::string_view argName) const
+        {
+            int argument = this->find(argName);
+            bool defined = argument >= 0 && this->defined(argument);
+            return detail::convertArgument<T>(
+                argName,
+                defined,
+                defined ? this->_parsedValues[argument] : std::string_view());
+        }
+
+    protected:
+
+        /** Finds an argument in the schema, or -1
+        */
+        int find(std::string_view argName) const
+        {
+            if(this->_schema == nullptr)
+                return -1;
+
+            int argument = this->_schema->findArgument(argName);
+            if(argument < 0)
+                argument = this->_schema->findPositional(argName);
+            return argument;
+        }
+    };
+
+
+    inline ParseResult Schema::parse(int argc, char** argv) const
+    {
+        ParseResult result;
+        this->parse(argc, argv, result);
+        return result;
+    }
+
+
+    inline void Schema::parse(int argc, char** argv, ParseResult& result) const
+    {
+        parse_status status = this->tryParse(argc, argv, result);
+        if(!status)
+        {
+            // Once a subcommand is selected, the error is in
+            // its part of the input
+            const ParseResult& failed = result._subcommand >= 0 ? result._subResults[0] : result;
+            parser::parsing_exception error(status.code, status.token, status.index, *failed._schema);
+            for(auto&& file : failed._mappedFiles)
+                if(file->contains(status.token))
+                    error.keepTokenAlive(file);
+
+            // These errors report the name of an argument,
+            // which belongs to the schema and not to argv
+            switch(status.code)
+            {
+            case parse_errc::missing_argument:
+            case parse_errc::excluded_argument:
+            case parse_errc::missing_dependency:
+            case parse_errc::missing_alternative:
+            case parse_errc::unexpected_value:
+                error.keepTokenCopy();
+                break;
+            default:
+                break;
+            }
+            SIMPLE_ARG_PARSER_THROW(error);
+        }
+    }
+
+
+    /** Result of one of the command-lines given to
+    *   Schema::parseBatch
+    */
+    struct batch_entry
+    {
+        /** Arguments found
+        */
+        ParseResult result;
+
+        /** Outcome of the parse
+        */
+        parse_status status;
+    };
+
+
+    inline std::vector<batch_entry> Schema::parseBatch(
+        const command_line* lines,
+        std::size_t count,
+        unsigned threads) const
+    {
+        if(!this->_frozen)
+            SIMPLE_ARG_PARSER_THROW(std::logic_error("Schema must be frozen before parse()"));
+
+        std::vector<batch_entry> entries(count);
+        detail::parallelFor(count, threads, [this, lines, &entries](std::size_t i)
+        {
+            entries[i].status = this->tryParse(
+                lines[i].argc, lines[i].argv, entries[i].result);
+        });
+        return entries;
+    }
+
+
+    inline std::vector<batch_entry> Schema::parseBatch(
+        const std::vector<command_line>& lines,
+        unsigned threads) const
+    {
+        return this->parseBatch(lines.data(), lines.size(), threads);
+    }
+
+
+    inline parse_status Schema::tryParse(int argc, char** argv, ParseResult& result) const
+    {
+        if(!this->_frozen)
+            SIMPLE_ARG_PARSER_THROW(std::logic_error("Schema must be frozen before parse()"));
+
+        if(result._schema != this || result._parsedValues.size() != this->size())
+            result.bind(*this);
+
+        // The subcommand of a previous parse is forgotten, so
+        // an error before any subcommand isn't reported with
+        // the schema of the old one
+        if(result._subcommand >= 0)
+        {
+            result._subResults[0].clear();
+            result._subcommand = -1;
+        }
+
+        parse_progress progress = { ARG_NAME, -1, false, -1, std::string_view(), 0, 0, 0, false };
+        int subcommand = -1;
+        int subcommandArg = argc;
+        for(int _arg = 1; _arg < argc; _arg++)
+        {
+            std::string_view currentArg(argv[_arg]);
+
+            // Values of an option passed through go with it,
+            // without being looked up
+            if(progress.passing)
+            {
+                if(progress.state == ARG_NAME && !progress.operands &&
+                   (currentArg.size() < 2 || currentArg[0] != '-'))
+                {
+                    result.passToken(_arg);
+                    continue;
+                }
+                progress.passing = false;
+            }
+
+            // The first positional token may select a
+            // subcommand, which parses the rest of argv
+            if(!this->_subcommandTable.empty() && progress.state == ARG_NAME && !progress.operands &&
+               progress.positional == 0 && progress.positionalValues == 0 &&
+               (currentArg.empty() || currentArg[0] != '-'))
+            {
+                subcommand = this->findSubcommand(currentArg);
+                if(subcommand >= 0)
+                {
+                    subcommandArg = _arg;
+                    break;
+                }
+            }
+
+            parse_status status;
+            if(this->_responseFiles && !progress.operands && !currentArg.empty() && currentArg[0] == '@')
+                status = this->parseResponseFile(currentArg, _arg, progress, result);
+            else
+                status = this->parseToken(currentArg, _arg, progress, result);
+
+            if(!status && status.code == parse_errc::unexpected_argument &&
+               this->_passthrough && status.index == _arg && status.token.data() == argv[_arg])
+            {
+                // An option with an inline value (--foo=bar)
+                // takes no more tokens
+                result.passToken(_arg);
+                progress.passing = currentArg.size() > 1 && currentArg[0] == '-' &&
+                    currentArg.find('=') == std::string_view::npos;
+                continue;
+            }
+            if(!status)
+                return status;
+        }
+
+        if(progress.state == ARG_VALUE || (progress.state == ARG_LIST &&
+           progress.pendingValues < this->_frozenArguments[progress.pendingArgument].values.minimum))
+            return parse_status{ parse_errc::missing_value, progress.pendingIndex, progress.pendingToken };
+
+        // The positional arguments aren't required when
+        // a subcommand takes their place
+        for(std::size_t slot = progress.positional; subcommand < 0 && slot < this->_positionals.size(); slot++)
+        {
+            auto&& data = this->_frozenArguments[this->_positionals[slot]];
+            std::uint32_t taken = slot == progress.positional ? progress.positionalValues : 0;
+            if(taken < data.values.minimum)
+                return parse_status{ parse_errc::missing_argument, -1, data.name };
+        }
+
+        result.groupLists();
+        parse_status status = this->checkConstraints(result);
+        if(!status || subcommand < 0)
+            return status;
+
+        // The subcommand sees its name as argv[0]
+        if(result._subResults.empty())
+            result._subResults.resize(1);
+        result._subcommand = subcommand;
+        ParseResult& subResult = result._subResults[0];
+        status = this->subcommandSchema(static_cast<std::size_t>(subcommand)).tryParse(
+            argc - subcommandArg, argv + subcommandArg, subResult);
+        if(status.index >= 0)
+            status.index += subcommandArg;
+        for(auto&& range : subResult._passthrough)
+        {
+            range.begin += subcommandArg;
+            range.end += subcommandArg;
+        }
+        return status;
+    }
+
+
+    inline parse_status Schema::checkConstraints(const ParseResult& result) const
+    {
+        for(auto&& constraint : this->_frozenConstraints)
+        {
+            if(constraint.trigger != NO_TRIGGER && !result.defined(constraint.trigger))
+                continue;
+
+            bool given = false;
+            for(std::uint32_t i = constraint.begin; i < constraint.end; i++)
+            {
+                auto&& mask = this->_constraintMasks[i];
+                std::uint64_t found = result._parsedDefined[mask.word] & mask.bits;
+                std::uint64_t base = std::uint64_t(mask.word) << 6;
+                switch(constraint.kind)
+                {
+                case REQUIRED:
+                case DEPENDENCY:
+                    if(found != mask.bits)
+                        return parse_status{
+                            constraint.kind == REQUIRED ? parse_errc::missing_argument : parse_errc::missing_dependency,
+                            -1,
+                            this->_frozenArguments[base + detail::lowestBit(mask.bits & ~found)].name };
+                    break;
+                case EXCLUSIVE:
+                    if(found != 0)
+                    {
+                        // Reports the second argument found
+                        if(!given)
+                            found &= found - 1;
+                        if(found != 0)
+                            return parse_status{ parse_errc::excluded_argument, -1,
+                                this->_frozenArguments[base + detail::lowestBit(found)].name };
+                        given = true;
+                    }
+                    break;
+                case AT_LEAST_ONE:
+                    given = given || found != 0;
+                    break;
+                }
+            }
+
+            if(constraint.kind == AT_LEAST_ONE && !given)
+            {
+                auto&& mask = this->_constraintMasks[constraint.begin];
+                return parse_status{ parse_errc::missing_alternative, -1,
+                    this->_frozenArguments[(std::uint64_t(mask.word) << 6) + detail::lowestBit(mask.bits)].name };
+            }
+        }
+        return parse_status{ parse_errc(), -1, std::string_view() };
+    }
+
+
+    inline parse_status Schema::parseToken(
+        std::string_view currentArg,
+        int _arg,
+        parse_progress& progress,
+        ParseResult& result) const
+    {
+        if(progress.state == ARG_VALUE)
+        {
+            LOG("parsing argument value");
+            LOG_VAR(currentArg);
+
+            progress.state = ARG_NAME;
+            return this->defineValue(progress.pendingArgument, currentArg, _arg, result);
+        }
+
+        if(progress.state == ARG_LIST)
+        {
+            // Once the minimum is taken, a token that looks
+            // like an option ends the list
+            bool optionLike = currentArg.size() > 1 && currentArg[0] == '-';
+            if(!optionLike || progress.pendingValues < this->_frozenArguments[progress.pendingArgument].values.minimum)
+            {
+                this->appendValue(currentArg, progress, result);
+                return parse_status{ parse_errc(), -1, std::string_view() };
+            }
+            progress.state = ARG_NAME;
+        }
+
+        if(progress.operands)
+        {
+            if(!this->definePositional(currentArg, progress, result))
+                result._operands.push_back(currentArg);
+            return parse_status{ parse_errc(), -1, std::string_view() };
+        }
+
+        int argument = this->findArgument(currentArg);
+        if(argument >= 0)
+            return this->defineArgument(argument, std::string_view(), false, currentArg, _arg, progress, result);
+
+        // Anything not looking like an option (a lone dash
+        // included) goes to the positional arguments
+        if(currentArg.size() < 2 || currentArg[0] != '-')
+        {
+            if(this->definePositional(currentArg, progress, result))
+                return parse_status{ parse_errc(), -1, std::string_view() };
+            return parse_status{ parse_errc::unexpected_argument, _arg, currentArg };
+        }
+        return this->parseOptionForms(currentArg, _arg, progress, result);
+    }
+
+
+    inline parse_status Schema::parseOptionForms(
+        std::string_view currentArg,
+        int _arg,
+        parse_progress& progress,
+        ParseResult& result) const
+    {
+        const parse_status unexpected{ parse_errc::unexpected_argument, _arg, currentArg };
+        if(currentArg.size() < 2 || currentArg[0] != '-')
+            return unexpected;
+
+        if(currentArg[1] == '-')
+        {
+            if(currentArg.size() == 2)
+            {
+                progress.operands = true;
+                return parse_status{ parse_errc(), -1, std::string_view() };
+            }
+
+            // --name=value
+            std::size_t equals = currentArg.find('=');
+            if(equals != std::string_view::npos)
+            {
+                int argument = this->findArgument(currentArg.substr(0, equals));
+                if(argument < 0)
+                    return unexpected;
+                return this->defineArgument(argument, currentArg.substr(equals + 1), true,
+                    currentArg, _arg, progress, result);
+            }
+
+            // --no-flag, for a registered --flag
+            if(currentArg.substr(0, 5) == "--no-")
+            {
+                int argument = this->findJoined("--", currentArg.substr(5));
+                if(argument < 0 || this->_frozenArguments[argument].hasValue)
+                    return unexpected;
+
+                result.negate(argument);
+                result._parsedCounts[argument] = 0;
+                return parse_status{ parse_errc(), -1, std::string_view() };
+            }
+            return unexpected;
+        }
+
+        // -abc clusters of short flags, where the first one
+        // taking a value takes the rest of the token (-j8).
+        // They are checked before defining any, so a bad
+        // cluster leaves the result untouched
+        for(std::size_t i = 1; i < currentArg.size(); i++)
+        {
+            unsigned char c = static_cast<unsigned char>(currentArg[i]);
+            int argument = c < 128 ? this->_shortOptions[c] : -1;
+            if(argument < 0)
+                return unexpected;
+            if(this->_frozenArguments[argument].hasValue)
+                break;
+        }
+
+        for(std::size_t i = 1; i < currentArg.size(); i++)
+        {
+            unsigned char c = static_cast<unsigned char>(currentArg[i]);
+            int argument = c < 128 ? this->_shortOptions[c] : -1;
+            if(argument < 0)
+                return unexpected;
+
+            if(this->_frozenArguments[argument].hasValue)
+            {
+                std::string_view value = currentArg.substr(i + 1);
+                return this->defineArgument(argument, value, !value.empty(),
+                    currentArg, _arg, progress, result);
+            }
+
+            parse_status status = this->defineArgument(argument, std::string_view(), false,
+                currentArg, _arg, progress, result);
+            if(!status)
+                return status;
+        }
+        return parse_status{ parse_errc(), -1, std::string_view() };
+    }
+
+
+    inline parse_status Schema::defineArgument(
+        int argument,
+        std::string_view value,
+        bool inlineValue,
+        std::string_view currentArg,
+        int _arg,
+        parse_progress& progress,
+        ParseResult& result) const
+    {
+        auto&& data = this->_frozenArguments[argument];
+        if(data.list >= 0)
+        {
+            result.define(argument);
+            result._parsedCounts[argument]++;
+            if(!data.values.repeatable)
+                result._listStarts[data.list] = static_cast<std::uint32_t>(result._listEntries.size());
+
+            progress.state = ARG_LIST;
+            progress.pendingArgument = argument;
+            progress.pendingIndex = _arg;
+            progress.pendingToken = currentArg;
+            progress.pendingValues = 0;
+            if(inlineValue)
+                this->appendValue(value, progress, result);
+            return parse_status{ parse_errc(), -1, std::string_view() };
+        }
+
+        if(data.hasValue)
+        {
+            if(inlineValue)
+                return this->defineValue(argument, value, _arg, result);
+
+            progress.state = ARG_VALUE;
+            progress.pendingArgument = argument;
+            progress.pendingIndex = _arg;
+            progress.pendingToken = currentArg;
+            return parse_status{ parse_errc(), -1, std::string_view() };
+        }
+
+        if(inlineValue)
+            return parse_status{ parse_errc::unexpected_value, _arg, data.name };
+
+        result.define(argument);
+        result._parsedValues[argument] = std::string_view();
+        result._parsedCounts[argument]++;
+        return parse_status{ parse_errc(), -1, std::string_view() };
+    }
+
+
+    inline bool Schema::definePositional(
+        std::string_view currentArg,
+        parse_progress& progress,
+        ParseResult& result) const
+    {
+        for(; progress.positional < this->_positionals.size(); progress.positional++)
+        {
+            std::uint32_t argument = this->_positionals[progress.positional];
+            auto&& data = this->_frozenArguments[argument];
+            if(progress.positionalValues == data.values.maximum)
+            {
+                progress.positionalValues = 0;
+                continue;
+            }
+
+            if(data.list >= 0)
+            {
+                if(progress.positionalValues == 0)
+                    result._listStarts[data.list] = static_cast<std::uint32_t>(result._listEntries.size());
+                result._listEntries.push_back({ static_cast<std::uint32_t>(data.list), currentArg });
+            }
+            result.define(argument);
+            result._parsedValues[argument] = currentArg;
+            result._parsedCounts[argument]++;
+            progress.positionalValues++;
+            return true;
+        }
+        return false;
+    }
+
+
+    inline void Schema::appendValue(
+        std::string_view value,
+        parse_progress& progress,
+        ParseResult& result) const
+    {
+        auto&& data = this->_frozenArguments[progress.pendingArgument];
+        result._parsedValues[progress.pendingArgument] = value;
+        result._listEntries.push_back({ static_cast<std::uint32_t>(data.list), value });
+        if(++progress.pendingValues == data.values.maximum)
+            progress.state = ARG_NAME;
+    }
+
+
+    inline parse_status Schema::defineValue(
+        int argument,
+        std::string_view value,
+        int _arg,
+        ParseResult& result) const
+    {
+        // Bound variables are only written by store(), once
+        // the whole parse succeeded
+        auto&& data = this->_frozenArguments[argument];
+        if(data.store != nullptr && data.store(value, nullptr) != std::errc())
+            return parse_status{ parse_errc::invalid_value, _arg, value };
+
+        result.define(argument);
+        result._parsedValues[argument] = value;
+        result._parsedCounts[argument]++;
+        return parse_status{ parse_errc(), -1, std::string_view() };
+    }
+
+
+    inline parse_status Schema::parseResponseFile(
+        std::string_view currentArg,
+        int _arg,
+        parse_progress& progress,
+        ParseResult& result) const
+    {
+        auto file = std::make_shared<detail::mapped_file>(
+            std::string(currentArg.substr(1)));
+        if(!file->valid())
+            return parse_status{ parse_errc::unreadable_response_file, _arg, currentArg };
+
+        parse_status status{ parse_errc(), -1, std::string_view() };
+        bool complete = detail::tokenizeResponseFile(
+            file->data(), file->size(),
+            [this, _arg, &progress, &result, &status](std::string_view token)
+            {
+                status = this->parseToken(token, _arg, progress, result);
+                return bool(status);
+            });
+
+        // A malformed file is rejected before any of its
+        // tokens, so the result doesn't point into it
+        if(status && !complete)
+            return parse_status{ parse_errc::malformed_response_file, _arg, currentArg };
+        result._mappedFiles.push_back(file);
+        return status;
+    }
+
+
+    /** Class responsible for parsing the command-line
+    *   input arguments. It receives the raw input data
+    *   and then parse it, returning a map.
+    *
+    *   It's a convenience over a Schema and a ParseResult,
+    *   bound to the argv given in the constructor. To
+    *   parse many inputs (possibly in many threads) with
+    *   the same arguments, use Schema directly
+    */
+    class ArgumentParser
+    {
+    protected:
+
+        /** Arguments registered in the class instance
+        */
+        Schema _schema;
+
+        /** Arguments parsed from the inputs in the
+        *   current execution
+        */
+        ParseResult _result;
+
+        /** number of input arguments (argc - 1)
+        */
+        int _numberOfArguments;
+
+        /** raw input arguments (argv)
+        */
+        char** _rawInput;
+
+    public:
+
+
+        /** Default constructor, used to redirect the input
+        *   arguments  directly to the class
+        *
+        *   @param argc
+        *       the same argc received as inputs to main.
+        *       It represents the number of command-line
+        *       arguments, including the program name
+        *
+        *   @param argv
+        *       also the argv received from main. It contains
+        *       an array of C-strings containing the input
+        *       arguments
+        */
+        ArgumentParser(int argc, char** argv) :
+            _schema(std::string(argv[0])),
+            _numberOfArguments(argc - 1),
+            _rawInput(argv)
+        {
+        }
+
+        /** Constructor for parsers that only receive their
+        *   inputs in parse(argc, argv), e.g. to parse many
+        *   command-lines with the same arguments
+        *
+        *   @param programName
+        *       name of the program, shown in the usage
+        */
+        explicit ArgumentParser(const std::string& programName = "") :
+            _schema(programName),
+            _numberOfArguments(0),
+            _rawInput(nullptr)
+        {
+        }
+
+        /** Copies another parser, including its results
+        */
+        ArgumentParser(const ArgumentParser& other) :
+            _schema(other._schema),
+            _result(other._result),
+            _numberOfArguments(other._numberOfArguments),
+            _rawInput(other._rawInput)
+        {
+            this->rebindResult(other);
+        }
+
+        /** Moves another parser, including its results
+        */
+        ArgumentParser(ArgumentParser&& other) :
+            _schema(std::move(other._schema)),
+            _result(std::move(other._result)),
+            _numberOfArguments(other._numberOfArguments),
+            _rawInput(other._rawInput)
+        {
+            this->rebindResult(other);
+        }
+
+        ArgumentParser& operator=(const ArgumentParser& other)
+        {
+            this->_schema = other._schema;
+            this->_result = other._result;
+            this->_numberOfArguments = other._numberOfArguments;
+            this->_rawInput = other._rawInput;
+            this->rebindResult(other);
+            return *this;
+        }
+
+        ArgumentParser& operator=(ArgumentParser&& other)
+        {
+            this->_schema = std::move(other._schema);
+            this->_result = std::move(other._result);
+            this->_numberOfArguments = other._numberOfArguments;
+            this->_rawInput = other._rawInput;
+            this->rebindResult(other);
+            return *this;
+        }
+
+
+        /** Includes a new expected command-line
+        *   argument. See Schema::addArgument
+        *
+        *   @throws std::logic_error
+        *       if the arguments were already frozen (by
+        *       freeze() or parse())
+        */
+        ArgHandle addArgument(
+            const std::string& name,
+            bool hasValue = false,
+            const std::string& description = "")
+        {
+            return this->_schema.addArgument(name, hasValue, description);
+        }
+
+        /** Includes a new expected command-line argument,
+        *   taking a number of values. See Schema::addArgument
+        *
+        *   @throws std::logic_error
+        *       if the arguments were already frozen (by
+        *       freeze() or parse())
+        */
+        ArgHandle addArgument(
+            const std::string& name,
+            arity values,
+            const std::string& description = "")
+        {
+            return this->_schema.addArgument(name, values, description);
+        }
+
+        /** Includes a positional argument, given by its
+        *   place instead of its name. See Schema::addPositional
+        *
+        *   @throws std::logic_error
+        *       if the arguments were already frozen (by
+        *       freeze() or parse())
+        */
+        ArgHandle addPositional(
+            const std::string& name,
+            arity values,
+            const std::string& description = "")
+        {
+            return this->_schema.addPositional(name, values, description);
+        }
+
+        /** Includes a positional argument taking a single
+        *   value. See Schema::addPositional
+        *
+        *   @throws std::logic_error
+        *       if the arguments were already frozen (by
+        *       freeze() or parse())
+        */
+        ArgHandle addPositional(
+            const std::string& name,
+            const std::string& description = "")
+        {
+            return this->_schema.addPositional(name, description);
+        }
+
+        /** Includes a subcommand, whose arguments are only
+        *   registered when it's selected. See
+        *   Schema::addSubcommand
+        *
+        *   @throws std::logic_error
+        *       if the arguments were already frozen (by
+        *       freeze() or parse())
+        */
+        void addSubcommand(
+            const std::string& name,
+            std::function<void(Schema&)> build,
+            const std::string& description = "")
+        {
+            this->_schema.addSubcommand(name, std::move(build), description);
+        }
+
+        /** Includes a new expected command-line argument,
+        *   bound to a variable, which receives the converted
+        *   value once parse() succeeds. See Schema::addArgument
+        *
+        *   @throws std::logic_error
+        *       if the arguments were already frozen (by
+        *       freeze() or parse())
+        */
+        template <typename T>
+        ArgHandle addArgument(
+            const std::string& name,
+            T* destination,
+            const std::string& description = "")
+        {
+            return this->_schema.addArgument(name, destination, description);
+        }
+
+        /** Compiles the registered arguments into a read-only
+        *   flat index. See Schema::freeze. It's called by
+        *   parse() if needed, and no argument can be added
+        *   after it
+        */
+        void freeze()
+        {
+            this->_schema.freeze();
+        }
+
+        /** Indicates if the arguments were frozen
+        */
+        bool isFrozen() const
+        {
+            return this->_schema.isFrozen();
+        }
+
+        /** Enables (or disables) the expansion of @path
+        *   response files. See Schema::enableResponseFiles
+        *
+        *   @param enable
+        *       whether @path tokens should be expanded
+        */
+        void enableResponseFiles(bool enable = true)
+        {
+            this->_schema.enableResponseFiles(enable);
+        }
+
+        /** Enables (or disables) the passthrough of unknown
+        *   tokens. See Schema::enablePassthrough
+        *
+        *   @throws std::logic_error
+        *       if the arguments were already frozen (by
+        *       freeze() or parse())
+        */
+        void enablePassthrough(bool enable = true)
+        {
+            this->_schema.enablePassthrough(enable);
+        }
+
+        /** Makes an argument required. See Schema::addRequired
+        */
+        void addRequired(ArgHandle argument)
+        {
+            this->_schema.addRequired(argument);
+        }
+
+        /** Makes arguments mutually exclusive. See
+        *   Schema::addExclusive
+        */
+        void addExclusive(std::initializer_list<ArgHandle> arguments)
+        {
+            this->_schema.addExclusive(arguments);
+        }
+
+        /** Makes an argument depend on another. See
+        *   Schema::addDependency
+        */
+        void addDependency(ArgHandle argument, ArgHandle dependency)
+        {
+            this->_schema.addDependency(argument, dependency);
+        }
+
+        /** Requires at least one of a group of arguments.
+        *   See Schema::addAtLeastOne
+        */
+        void addAtLeastOne(std::initializer_list<ArgHandle> arguments)
+        {
+            this->_schema.addAtLeastOne(arguments);
+        }
+
+        /** Prints instructions of the program to the
+        *   terminal
+        */
+        std::string usage() const
+        {
+            return this->_schema.usage();
+        }
+
+        /** Writes the instructions of the program straight
+        *   to a sink. See Schema::writeUsage
+        *
+        *   @param sink
+        *       destination of the text (a std::ostream,
+        *       FILE*, std::string or caller buffer)
+        *
+        *   @param [in] width
+        *       number of columns, by default the width of
+        *       the terminal the sink writes to
+        *
+        *   @return length of the text
+        */
+        std::size_t writeUsage(
+            output_sink&& sink,
+            std::size_t width = output_sink::TERMINAL_WIDTH) const
+        {
+            return this->_schema.writeUsage(std::move(sink), width);
+        }
+
+        /** Answers a shell completion request given to the
+        *   constructor. See Schema::handleCompletion. Call it
+        *   instead of parse(), and exit if it returns true:
+        *
+        *       if(argParser.handleCompletion())
+        *           return 0;
+        *       argParser.parse();
+        *
+        *   @param out
+        *       stream receiving the candidates
+        *
+        *   @return false if the input isn't a completion
+        *       request
+        */
+        bool handleCompletion(std::ostream& out = std::cout)
+        {
+            this->_schema.freeze();
+            return this->_schema.handleCompletion(
+                this->_numberOfArguments + 1, this->_rawInput, out);
+        }
+
+        /** Writes a bash or zsh completion script. See
+        *   Schema::writeCompletionScript
+        *
+        *   @param out
+        *       stream receiving the script
+        *
+        *   @param shell
+        *       shell running the script
+        */
+        void writeCompletionScript(
+            std::ostream& out,
+            completion_shell shell = completion_shell::bash) const
+        {
+            this->_schema.writeCompletionScript(out, shell);
+        }
+
+        /** Parses the raw command-line input and
+        *   updates a map with the name of the arguments
+        *   given and the views of its values to be converted.
+        *
+        *   The values are not copied: they point to the
+        *   argv given in the constructor, which must outlive
+        *   the parser (the argv received by main always does)
+        */
+        void parse()
+        {
+            this->_schema.freeze();
+            this->_schema.parse(this->_numberOfArguments + 1, this->_rawInput, this->_result);
+            this->_result.store();
+        }
+
+        /** Parses the input given to the constructor, like
+        *   parse(), but returns the errors instead of
+        *   throwing them. See Schema::tryParse
+        *
+        *   @return the outcome of the parse
+        */
+        parse_status tryParse()
+        {
+            this->_schema.freeze();
+            parse_status status = this->_schema.tryParse(this->_numberOfArguments + 1, this->_rawInput, this->_result);
+            if(status)
+                this->_result.store();
+            return status;
+        }
+
+        /** Parses a new command-line input, replacing the
+        *   results of the previous parses. The memory of the
+        *   results is reused, so parsing many inputs with the
+        *   same parser does no allocation after the first one
+        *   (as long as no response file is read).
+        *
+        *   @param argc
+        *       number of arguments, including the
+        *       program name
+        *
+        *   @param argv
+        *       the arguments. The values point into it, so
+        *       it must outlive the results (or the next parse)
+        */
+        void parse(int argc, char** argv)
+        {
+            this->_numberOfArguments = argc - 1;
+            this->_rawInput = argv;
+            this->_result.clear();
+            this->parse();
+        }
+
+        /** Parses a new command-line input, like
+        *   parse(argc, argv), but returns the errors instead
+        *   of throwing them. See Schema::tryParse
+        *
+        *   @param argc
+        *       number of arguments, including the
+        *       program name
+        *
+        *   @param argv
+        *       the arguments
+        *
+        *   @return the outcome of the parse
+        */
+        parse_status tryParse(int argc, char** argv)
+        {
+            this->_numberOfArguments = argc - 1;
+            this->_rawInput = argv;
+            this->_result.clear();
+            return this->tryParse();
+        }
+
+        /** Arguments registered in the parser
+        */
+        const Schema& schema() const
+        {
+            return this->_schema;
+        }
+
+        /** Arguments found by parse()
+        */
+        const ParseResult& result() const
+        {
+            return this->_result;
+        }
+
+
+        /** Verifies if a giver argument is defined
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        bool isDefined(ArgHandle handle) const
+        {
+            return this->_result.isDefined(handle);
+        }
+
+
+        /** Verifies if a giver argument is defined
+        *
+        *   @param [in] argName
+        *       name of the argument to be verified
+        */
+        bool isDefined(std::string_view argName) const
+        {
+            return this->_result.isDefined(argName);
+        }
+
+
+        /** Number of times an argument was given
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        std::size_t count(ArgHandle handle) const
+        {
+            return this->_result.count(handle);
+        }
+
+
+        /** Number of times an argument was given
+        *
+        *   @param [in] argName
+        *       name of the argument
+        */
+        std::size_t count(std::string_view argName) const
+        {
+            return this->_result.count(argName);
+        }
+
+
+        /** Tokens given after the -- terminator
+        */
+        const std::vector<std::string_view>& operands() const
+        {
+            return this->_result.operands();
+        }
+
+
+        /** Values of an argument. See ParseResult::values
+        *
+        *   @param handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        value_range values(ArgHandle handle) const
+        {
+            return this->_result.values(handle);
+        }
+
+
+        /** Values of an argument. See ParseResult::values
+        *
+        *   @param argName
+        *       name of the argument
+        */
+        value_range values(std::string_view argName) const
+        {
+            return this->_result.values(argName);
+        }
+
+
+        /** Tokens of argv passed through. See
+        *   ParseResult::passthrough
+        */
+        const std::vector<argv_range>& passthrough() const
+        {
+            return this->_result.passthrough();
+        }
+
+
+        /** Name of the subcommand selected, or an empty
+        *   view if none was
+        */
+        std::string_view subcommand() const
+        {
+            return this->_result.subcommand();
+        }
+
+
+        /** Arguments of the subcommand selected, or
+        *   nullptr if none was. See ParseResult::subcommandResult
+        */
+        const ParseResult* subcommandResult() const
+        {
+            return this->_result.subcommandResult();
+        }
+
+
+        /** Verifies if a given argument constains an extra
+        *   value
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        bool hasValue(ArgHandle handle) const
+        {
+            return this->_result.hasValue(handle);
+        }
+
+
+        /** Verifies if a given argument constains an extra
+        *   value
+        *
+        *   @param [in] argName
+        *       name of the argument to be verified
+        */
+        bool hasValue(std::string_view argName) const
+        {
+            return this->_result.hasValue(argName);
+        }
+
+        /** Retrieve the raw argument value without any copy
+        *   or conversion. The view points into the argv given
+        *   in the constructor. If the argument was not defined,
+        *   or is a flag with no value, the view is empty
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        */
+        std::string_view getArgumentView(ArgHandle handle) const
+        {
+            return this->_result.getArgumentView(handle);
+        }
+
+        /** Retrieve the raw argument value without any copy
+        *   or conversion. The view points into the argv given
+        *   in the constructor. If the argument was not defined,
+        *   or is a flag with no value, the view is empty
+        *
+        *   @param [in] argName
+        *       name of the argument to be retrieved
+        */
+        std::string_view getArgumentView(std::string_view argName) const
+        {
+            return this->_result.getArgumentView(argName);
+        }
+
+        /** Retrieve the argument value, converted to T
+        *   by parser::convert
+        *
+        *   @param [in] handle
+        *       handle of the argument, as returned
+        *       by addArgument
+        *
+        *   @throws parser::conversion_exception
+        *       if the argument was not defined, or if its
+        *       value is malformed or out of range for T
+        */
+        template <typename T>
+        T getArgument(ArgHandle handle) const
+        {
+            return this->_result.getArgument<T>(handle);
+        }
+
+        /** Retrieve the argument value, converted to T
+        *   by parser::convert
+        *
+        *   @param [in] argName
+        *       name of the argument to be verified
+        *
+        *   @throws parser::conversion_exception
+        *       if the argument was not defined, or if its
+        *       value is malformed or out of range for T
+        */
+        template <typename T>
+        T getArgument(std::string_view argName) const
+        {
+            return this->_result.getArgument<T>(argName);
+        }
+
+    protected:
+
+        /** Points the copied result to the schema of this
+        *   parser, when it pointed to the schema of the
+        *   original one
+        */
+        void rebindResult(const ArgumentParser& other)
+        {
+            if(this->_result._schema == &other._schema)
+                this->_result.retarget(this->_schema);
+        }
+    };
+
+
+    /** Description of an argument known at compile time,
+    *   used to declare a parser::StaticSchema. E.g.:
+    *
+    *       constexpr parser::option options[] = {
+    *           { "--size", true, "Size of the vector" },
+    *           { "--debug" }
+    *       };
+    */
+    struct option
+    {
+        /** Name of the argument, as expected in the
+        *   command-line
+        */
+        std::string_view name;
+
+        /** Indicates if the argument is followed
+        *   by a value in command-line
+        */
+        bool hasValue = false;
+
+        /** Description of the argument, shown in the usage
+        */
+        std::string_view description = std::string_view();
+    };
+
+
+    template <std::size_t N>
+    class StaticParseResult;
+
+
+    /** Set of arguments declared at compile time.
+    *
+    *   The schema is built by a constexpr constructor that
+    *   generates a minimal perfect hash of the names
+    *   (hash and displace), so classifying a token costs
+    *   one hash of the token and one comparison against
+    *   the only candidate name, with no map and no runtime
+    *   registration. Use parser::makeSchema to create it:
+    *
+    *       constexpr auto schema = parser::makeSchema(options);
+    *       constexpr int SIZE = schema.find("--size");
+    *
+    *       auto result = schema.parse(argc, argv);
+    *       if(result.isDefined(SIZE)) ...
+    */
+    template <std::size_t N>
+    class StaticSchema
+    {
+    public:
+        /** Number of slots in the hash table
+        */
+        static constexpr std::size_t tableSize = detail::tableSizeFor(N);
+
+    protected:
+        /** Arguments in the order they were declared
+        */
+        std::array<option, N> _options;
+
+        /** Displacement of each bucket of the first hash level
+        */
+        std::array<std::uint64_t, N> _displacement;
+
+        /** Hash table slots, holding (index + 1) of the
+        *   argument stored there, or 0 when empty
+        */
+        std::array<std::uint32_t, tableSize> _table;
+
+        /** Pre-filter of the tokens that can be names
+        */
+        detail::name_filter _filter;
+
+        /** Slot of a hash for a given displacement
+        */
+        static constexpr std::size_t slotOf(std::uint64_t hash, std::uint64_t displacement)
+        {
+            return detail::mixHash(hash + displacement) & (tableSize - 1);
+        }
+
+        /** Indices of the arguments sorted by name, the
+        *   order of the usage
+        */
+        std::array<std::uint32_t, N> sortedByName() const
+        {
+            std::array<std::uint32_t, N> sorted{};
+            for(std::size_t i = 0; i < N; i++)
+                sorted[i] = static_cast<std::uint32_t>(i);
+            std::sort(sorted.begin(), sorted.end(), [this](auto a, auto b)
+            {
+                return this->_options[a].name < this->_options[b].name;
+            });
+            return sorted;
+        }
+
+    public:
+
+        /** Builds the schema and its perfect hash. Meant to
+        *   run at compile time: duplicated names make it
+        *   fail to compile (or throw std::logic_error
+        *   if evaluated at runtime)
+        *
+        *   @param options
+        *       arguments accepted by the schema
+        */
+        constexpr StaticSchema(const option (&options)[N]) :
+            _options(), _displacement(), _table(), _filter()
+        {
+            std::array<std::uint64_t, N> hashes{};
+            std::array<std::size_t, N> bucketHead{};
+            std::array<std::size_t, N> bucketNext{};
+            std::array<std::size_t, N> bucketSize{};
+            std::size_t largestBucket = 0;
+
+            for(std::size_t i = 0; i < N; i++)
+            {
+                _options[i] = options[i];
+                hashes[i] = detail::hashName(options[i].name);
+                _filter.add(options[i].name);
+
+                // Buckets as linked lists of (index + 1). Equal
+                // names always share a bucket, so it's enough
+                // to look for duplicates there
+                std::size_t bucket = hashes[i] % N;
+                for(std::size_t item = bucketHead[bucket]; item != 0; item = bucketNext[item - 1])
+                    if(_options[item - 1].name == options[i].name)
+                        SIMPLE_ARG_PARSER_THROW(std::logic_error("Duplicated argument in StaticSchema"));
+
+                bucketNext[i] = bucketHead[bucket];
+                bucketHead[bucket] = i + 1;
+                bucketSize[bucket]++;
+                if(bucketSize[bucket] > largestBucket)
+                    largestBucket = bucketSize[bucket];
+            }
+
+            // Places the largest buckets first, searching for a
+            // displacement that sends all their names to free slots
+            std::array<std::size_t, N> slots{};
+            for(std::size_t size = largestBucket; size > 0; size--)
+            {
+                for(std::size_t bucket = 0; bucket < N; bucket++)
+                {
+                    if(bucketSize[bucket] != size)
+                        continue;
+
+                    std::uint64_t displacement = 0;
+                    for(;; displacement++)
+                    {
+                        if(displacement > (1u << 24))
+                            SIMPLE_ARG_PARSER_THROW(std::logic_error("Unable to build the StaticSchema hash"));
+
+                        bool fits = true;
+                        std::size_t placed = 0;
+                        for(std::size_t item = bucketHead[bucket]; item != 0 && fits; item = bucketNext[item - 1])
+                        {
+                            std::size_t slot = slotOf(hashes[item - 1], displacement);
+                            fits = _table[slot] == 0;
+                            for(std::size_t k = 0; k < placed && fits; k++)
+                                fits = slots[k] != slot;
+                            slots[placed++] = slot;
+                        }
+                        if(fits)
+                            break;
+                    }
+
+                    _displacement[bucket] = displacement;
+                    for(std::size_t item = bucketHead[bucket]; item != 0; item = bucketNext[item - 1])
+                        _table[slotOf(hashes[item - 1], displacement)] = static_cast<std::uint32_t>(item);
+                }
+            }
+        }
+
+        /** Finds the index of an argument, in the order
+        *   they were declared
+        *
+        *   @param [in] name
+        *       name of the argument
+        *
+        *   @return the index or -1 if the name is unknown
+        */
+        constexpr int find(std::string_view name) const
+        {
+            if(!_filter.mayContain(name))
+                return -1;
+
+            std::uint64_t hash = detail::hashName(name);
+            std::uint32_t item = _table[slotOf(hash, _displacement[hash % N])];
+            if(item != 0 && _options[item - 1].name == name)
+                return static_cast<int>(item - 1);
+            return -1;
+        }
+
+        /** Number of arguments in the schema
+        */
+        constexpr std::size_t size() const
+        {
+            return N;
+        }
+
+        /** Access to the declaration of an argument
+        *
+        *   @param [in] index
+        *       index of the argument, as given by find
+        */
+        constexpr const option& operator[](int index) const
+        {
+            return _options[index];
+        }
+
+        /** Returns the instructions of the program, in the
+        *   same format and order as ArgumentParser::usage
+        *
+        *   @param [in] programName
+        *       name of the program (argv[0])
+        */
+        std::string usage(std::string_view programName) const
+        {
+            auto sorted = this->sortedByName();
+            return detail::usageText(programName, [this, &sorted](auto&& visitor)
+            {
+                for(auto index : sorted)
+                {
+                    auto&& arg = this->_options[index];
+                    visitor(arg.name, arg.hasValue, arg.description);
+                }
+            });
+        }
+
+        /** Writes the instructions of the program straight
+        *   to a sink, wrapped to a number of columns. See
+        *   Schema::writeUsage
+        *
+        *   @param sink
+        *       destination of the text (a std::ostream,
+        *       FILE*, std::string or caller buffer)
+        *
+        *   @param [in] programName
+        *       name of the program (argv[0])
+        *
+        *   @param [in] width
+        *       number of columns, by default the width of
+        *       the terminal the sink writes to
+        *
+        *   @return length of the text
+        */
+        std::size_t writeUsage(
+            output_sink&& sink,
+            std::string_view programName,
+            std::size_t width = output_sink::TERMINAL_WIDTH) const
+        {
+            auto sorted = this->sortedByName();
+            detail::writeUsageText(sink, programName, width, [this, &sorted](auto&& visitor)
+            {
+                for(auto index : sorted)
+                {
+                    auto&& arg = this->_options[index];
+                    visitor(arg.name, arg.hasValue, arg.description);
+                }
+            });
+            sink.flush();
+            return sink.written();
+        }
+
+        /** Visits the names starting with a prefix, in the
+        *   order they were declared
+        *
+        *   @param [in] prefix
+        *       beginning of the names
+        *
+        *   @param visitor
+        *       callable receiving each name
+        */
+        template <typename Visitor>
+        void completions(std::string_view prefix, Visitor visitor) const
+        {
+            for(auto&& arg : _options)
+                if(arg.name.substr(0, prefix.size()) == prefix)
+                    visitor(arg.name);
+        }
+
+        /** Answers a shell completion request. Works like
+        *   Schema::handleCompletion, but with nothing to
+        *   register or index at startup
+        *
+        *   @param argc, argv
+        *       the input received by main
+        *
+        *   @param out
+        *       stream receiving the candidates
+        *
+        *   @return false if the input isn't a completion
+        *       request
+        */
+        bool handleCompletion(int argc, char** argv, std::ostream& out = std::cout) const
+        {
+            return detail::answerCompletion(argc, argv, out,
+                [this](std::string_view name)
+                {
+                    int argument = this->find(name);
+                    return argument >= 0 && _options[argument].hasValue;
+                },
+                [this](std::string_view prefix, auto&& visitor)
+                {
+                    this->completions(prefix, visitor);
+                });
+        }
+
+        /** Writes a bash or zsh completion script. See
+        *   Schema::writeCompletionScript
+        *
+        *   @param out
+        *       stream receiving the script
+        *
+        *   @param shell
+        *       shell running the script
+        *
+        *   @param programName
+        *       name of the program (argv[0])
+        */
+        void writeCompletionScript(
+            std::ostream& out,
+            completion_shell shell,
+            std::string_view programName) const
+        {
+            detail::writeCompletionScript(out, shell, programName);
+        }
+
+        /** Parses the raw command-line input. Works like
+        *   ArgumentParser::parse, but the schema isn't
+        *   modified, so the same schema can parse any
+        *   number of inputs
+        *
+        *   @param argc
+        *       the same argc received as inputs to main
+        *
+        *   @param argv
+        *       the argv received from main. The results
+        *       point into it, so it must outlive them
+        *
+        *   @throws parser::parsing_exception
+        *       if an argument is not expected
+        */
+        StaticParseResult<N> parse(int argc, char** argv) const
+        {
+            StaticParseResult<N> result(*this);
+            parse_status status = this->tryParse(argc, argv, result);
+            if(!status)
+                SIMPLE_ARG_PARSER_THROW(parser::parsing_exception(
+                    status.code, status.token, status.index, *this, argv[0]));
+            return result;
+        }
+
+        /** Parses the raw command-line input, returning the
+        *   errors instead of throwing them
+        *
+        *   @param argc
+        *       the same argc received as inputs to main
+        *
+        *   @param argv
+        *       the argv received from main. The results
+        *       point into it, so it must outlive them
+        *
+        *   @param [out] result
+        *       result receiving the arguments found. It must
+        *       have been created for this schema
+        *
+        *   @return the outcome of the parse
+        */
+        parse_status tryParse(int argc, char** argv, StaticParseResult<N>& result) const
+        {
+            int name = -1;
+            for(int _arg = 1; _arg < argc; _arg++)
+            {
+                std::string_view currentArg(argv[_arg]);
+                if(name < 0)
+                {
+                    int argument = this->find(currentArg);
+                    if(argument < 0)
+                        return parse_status{ parse_errc::unexpected_argument, _arg, currentArg };
+
+                    if(_options[argument].hasValue)
+                        name = argument;
+                    else
+                        result._defined[argument] = true;
+                }
+                else
+                {
+                    result._defined[name] = true;
+                    result._values[name] = currentArg;
+                    name = -1;
+                }
+            }
+            // The last token named an argument but its value never came
+            if(name >= 0)
+                return parse_status{ parse_errc::missing_value, argc - 1, std::string_view(argv[argc - 1]) };
+            return parse_status{ parse_errc(), -1, std::string_view() };
+        }
+    };
+
+
+    /** Creates a parser::StaticSchema from an array of
+    *   parser::option, deducing its size
+    *
+    *   @param options
+    *       arguments accepted by the schema
+    */
+    template <std::size_t N>
+    constexpr StaticSchema<N> makeSchema(const option (&options)[N])
+    {
+        return StaticSchema<N>(options);
+    }
+
+
+    /** Results of StaticSchema::parse. The arguments can
+    *   be accessed by name or, skipping the hash, by the
+    *   index given by StaticSchema::find. The schema must
+    *   outlive the result
+    */
+    template <std::size_t N>
+    class StaticParseResult
+    {
+        friend class StaticSchema<N>;
+
+    protected:
+        /** Schema used to parse the arguments
+        */
+        const StaticSchema<N>* _schema;
+
+        /** Views of the values, pointing into argv
+        */
+        std::array<std::string_view, N> _values;
+
+        /** Indicates which arguments were given
+        */
+        std::array<bool, N> _defined;
+
+    public:
+
+        /** Creates an empty result for a schema
+        *
+        *   @param schema
+        *       schema of the arguments
+        */
+        explicit StaticParseResult(const StaticSchema<N>& schema) :
+            _schema(&schema), _values(), _defined()
+        { }
+
+        /** Verifies if a given argument is defined
+        *
+        *   @param [in] index
+        *       index of the argument, as given by
+        *       StaticSchema::find
+        */
+        bool isDefined(int index) const
+        {
+            return index >= 0 && this->_defined[index];
+        }
+
+        /** Verifies if a given argument is defined
+        *
+        *   @param [in] argName
+        *       name of the argument to be verified
+        */
+        bool isDefined(std::string_view argName) const
+        {
+            return this->isDefined(this->_schema->find(argName));
+        }
+
+        /** Verifies if a given argument is defined and
+        *   contains an extra value
+        *
+        *   @param [in] index
+        *       index of the argument, as given by
+        *       StaticSchema::find
+        */
+        bool hasValue(int index) const
+        {
+            return this->isDefined(index) && (*this->_schema)[index].hasValue;
+        }
+
+        /** Verifies if a given argument is defined and
+        *   contains an extra value
+        *
+        *   @param [in] argName
+        *       name of the argument to be verified
+        */
+        bool hasValue(std::string_view argName) const
+        {
+            return this->hasValue(this->_schema->find(argName));
+        }
+
+        /** Retrieve the raw argument value, or an empty view
+        *
+        *   @param [in] index
+        *       index of the argument, as given by
+        *       StaticSchema::find
+        */
+        std::string_view getArgumentView(int index) const
+        {
+            return this->isDefined(index) ? this->_values[index] : std::string_view();
+        }
+
+        /** Retrieve the raw argument value, or an empty view
+        *
+        *   @param [in] argName
+        *       name of the argument to be retrieved
+        */
+        std::string_view getArgumentView(std::string_view argName) const
+        {
+            return this->getArgumentView(this->_schema->find(argName));
+        }
+
+        /** Retrieve the argument value, converted to T
+        *   by parser::convert
+        *
+        *   @param [in] index
+        *       index of the argument, as given by
+        *       StaticSchema::find
+        *
+        *   @throws parser::conversion_exception
+        *       if the argument was not defined, or if its
+        *       value is malformed or out of range for T
+        */
+        template <typename T>
+        T getArgument(int index) const
+        {
+            return detail::convertArgument<T>(
+                index >= 0 ? (*this->_schema)[index].name : std::string_view(),
+                this->isDefined(index),
+                this->getArgumentView(index));
+        }
+
+        /** Retrieve the argument value, converted to T
+        *   by parser::convert
+        *
+        *   @param [in] argName
+        *       name of the argument to be retrieved
+        *
+        *   @throws parser::conversion_exception
+        *       if the argument was not defined, or if its
+        *       value is malformed or out of range for T
+        */
+        template <typename T>
+        T getArgument(std::string_view argName) const
+        {
+            int index = this->_schema->find(argName);
+            return detail::convertArgument<T>(
+                argName,
+                this->isDefined(index),
+                this->getArgumentView(index));
+        }
+    };
+
+
+    /** Binds an argument to a member of a struct, used to
+    *   declare a parser::StructSchema. A bool member makes
+    *   the argument a flag; any other type takes a value,
+    *   converted by parser::convert. E.g.:
+    *
+    *       parser::field("--size", &Config::size, "Size of the vector")
+    */
+    template <typename Struct, typename T>
+    struct field
+    {
+        /** Struct the member belongs to
+        */
+        typedef Struct struct_type;
+
+        /** Type of the member
+        */
+        typedef T value_type;
+
+        /** Name of the argument, as expected in the
+        *   command-line
+        */
+        std::string_view name;
+
+        /** Member receiving the value
+        */
+        T Struct::* member;
+
+        /** Description of the argument, shown in the usage
+        */
+        std::string_view description;
+
+        /** Creates the binding
+        *
+        *   @param name
+        *       name of the argument
+        *
+        *   @param member
+        *       member receiving the value
+        *
+        *   @param description
+        *       description of the argument
+        */
+        constexpr field(
+            std::string_view name,
+            T Struct::* member,
+            std::string_view description = std::string_view()) :
+            name(name), member(member), description(description)
+        { }
+
+        /** Declaration of the argument in a StaticSchema
+        */
+        constexpr option toOption() const
+        {
+            return option{ name, !std::is_same_v<T, bool>, description };
+        }
+    };
+
+
+    /** Set of arguments bound to the members of a struct,
+    *   declared at compile time. Parsing fills the struct
+    *   in one pass: the names are classified by the perfect
+    *   hash of a parser::StaticSchema, and each index
+    *   dispatches, through a table generated at compile
+    *   time, to the conversion of its member. Use
+    *   parser::makeSchema to create it:
+    *
+    *       struct Config { int size = 10; bool debug = false; };
+    *
+    *       constexpr auto schema = parser::makeSchema(
+    *           parser::field("--size", &Config::size, "Size of the vector"),
+    *           parser::field("--debug", &Config::debug, "for debug messages"));
+    *
+    *       Config config = schema.parse(argc, argv);
+    */
+    template <typename Struct, typename... Fields>
+    class StructSchema
+    {
+        static_assert(sizeof...(Fields) > 0, "A StructSchema needs at least one field");
+        static_assert((std::is_same_v<typename Fields::struct_type, Struct> && ...),
+            "All the fields of a StructSchema must belong to the same struct");
+
+    public:
+        /** Number of arguments in the schema
+        */
+        static constexpr std::size_t fieldCount = sizeof...(Fields);
+
+    protected:
+        /** Converts a value into a member of the struct
+        */
+        typedef std::errc (*store_function)(const StructSchema&, std::string_view, Struct&);
+
+        /** Schema of the names, in the order of the fields
+        */
+        StaticSchema<fieldCount> _schema;
+
+        /** Bindings of the members
+        */
+        std::tuple<Fields...> _fields;
+
+        /** Builds the StaticSchema of the fields
+        */
+        static constexpr StaticSchema<fieldCount> schemaOf(const Fields&... fields)
+        {
+            const option options[fieldCount] = { fields.toOption()... };
+            return StaticSchema<fieldCount>(options);
+        }
+
+        /** Stores a value into the member of the field I
+        */
+        template <std::size_t I>
+        static std::errc store(const StructSchema& self, std::string_view text, Struct& target)
+        {
+            auto&& binding = std::get<I>(self._fields);
+            typedef typename std::tuple_element_t<I, std::tuple<Fields...>>::value_type value_type;
+            if constexpr (std::is_same_v<value_type, bool>)
+            {
+                target.*binding.member = true;
+                return std::errc();
+            }
+            else
+                return parser::convert(text, target.*binding.member);
+        }
+
+        /** Table with the store function of each field
+        */
+        template <std::size_t... I>
+        static constexpr std::array<store_function, fieldCount> dispatchTable(std::index_sequence<I...>)
+        {
+            return { { &StructSchema::store<I>... } };
+        }
+
+    public:
+
+        /** Builds the schema. Meant to run at compile time:
+        *   duplicated names make it fail to compile
+        *
+        *   @param fields
+        *       bindings of the arguments
+        */
+        constexpr StructSchema(const Fields&... fields) :
+            _schema(schemaOf(fields...)), _fields(fields...)
+        { }
+
+        /** Finds the index of an argument, in the order
+        *   the fields were declared
+        *
+        *   @param [in] name
+        *       name of the argument
+        *
+        *   @return the index or -1 if the name is unknown
+        */
+        constexpr int find(std::string_view name) const
+        {
+            return _schema.find(name);
+        }
+
+        /** Number of arguments in the schema
+        */
+        constexpr std::size_t size() const
+        {
+            return fieldCount;
+        }
+
+        /** Returns the instructions of the program, in the
+        *   same format and order as ArgumentParser::usage
+        *
+        *   @param [in] programName
+        *       name of the program (argv[0])
+        */
+        std::string usage(std::string_view programName) const
+        {
+            return _schema.usage(programName);
+        }
+
+        /** Writes the instructions of the program straight
+        *   to a sink. See StaticSchema::writeUsage
+        */
+        std::size_t writeUsage(
+            output_sink&& sink,
+            std::string_view programName,
+            std::size_t width = output_sink::TERMINAL_WIDTH) const
+        {
+            return _schema.writeUsage(std::move(sink), programName, width);
+        }
+
+        /** Parses the raw command-line input into a struct.
+        *   Members whose arguments aren't given keep their
+        *   values
+        *
+        *   @param argc
+        *       the same argc received as inputs to main
+        *
+        *   @param argv
+        *       the argv received from main
         *
+        *   @param [out] target
+        *       struct receiving the values
+        *
+        *   @throws parser::parsing_exception
+        *       if an argument is not expected or a value
+        *       can't be converted to its member
         */
-        const std::string _usage;
-
-    public:
+        void parse(int argc, char** argv, Struct& target) const
+        {
+            parse_status status = this->tryParse(argc, argv, target);
+            if(!status)
+                SIMPLE_ARG_PARSER_THROW(parser::parsing_exception(
+                    status.code, status.token, status.index, *this, argv[0]));
+        }
 
-        /** Basic constructor for const string
+        /** Parses the raw command-line input into a struct,
+        *   returning the errors instead of throwing them
         *
-        *   @param msg
-        *       Message explaining the error found
+        *   @param argc
+        *       the same argc received as inputs to main
         *
-        *   @param usage
-        *       Usage of the command-line arguments
+        *   @param argv
+        *       the argv received from main
         *
+        *   @param [out] target
+        *       struct receiving the values. Members found
+        *       before an error are kept
+        *
+        *   @return the outcome of the parse
         */
-        parsing_exception(
-            const std::string& _msg,
-            const std::string& _usage) :
-            std::runtime_error(_msg),
-            _usage(_usage)
-        { }
+        parse_status tryParse(int argc, char** argv, Struct& target) const
+        {
+            static constexpr std::array<store_function, fieldCount> dispatch =
+                dispatchTable(std::index_sequence_for<Fields...>());
 
+            int name = -1;
+            for(int _arg = 1; _arg < argc; _arg++)
+            {
+                std::string_view currentArg(argv[_arg]);
+                if(name < 0)
+                {
+                    int argument = _schema.find(currentArg);
+                    if(argument < 0)
+                        return parse_status{ parse_errc::unexpected_argument, _arg, currentArg };
 
-        /** Basic constructor for const char*
+                    if(_schema[argument].hasValue)
+                        name = argument;
+                    else
+                        dispatch[argument](*this, std::string_view(), target);
+                }
+                else
+                {
+                    if(dispatch[name](*this, currentArg, target) != std::errc())
+                        return parse_status{ parse_errc::invalid_value, _arg, currentArg };
+                    name = -1;
+                }
+            }
+            if(name >= 0)
+                return parse_status{ parse_errc::missing_value, argc - 1, std::string_view(argv[argc - 1]) };
+            return parse_status{ parse_errc(), -1, std::string_view() };
+        }
+
+        /** Parses the raw command-line input into a new
+        *   struct, value-initialized (so the default member
+        *   initializers apply)
         *
-        *   @param msg
-        *       Message explaining the error found
+        *   @param argc
+        *       the same argc received as inputs to main
         *
-        *   @param usage
-        *       Usage of the command-line arguments
+        *   @param argv
+        *       the argv received from main
         *
+        *   @throws parser::parsing_exception
+        *       if an argument is not expected or a value
+        *       can't be converted to its member
         */
-        parsing_exception(
-            const char* _msg,
-            const char* _usage) :
-            std::runtime_error(_msg),
-            _usage(_usage)
-        { }
-
-        /** Returns the usage of the CLI. This string
-        *   is here to make our lives easier
-        */
-        std::string usage() const
+        Struct parse(int argc, char** argv) const
         {
-            return this->_usage;
+            Struct target{};
+            this->parse(argc, argv, target);
+            return target;
         }
+    };
 
 
-        std::string message()
-        {
-            std::string msg = this->what();
-            msg += "\n";
-            msg += this->_usage;
-            return msg;
-        }
-    };
+    /** Creates a parser::StructSchema from the bindings of
+    *   the members of a struct
+    *
+    *   @param first, fields
+    *       bindings of the arguments
+    */
+    template <typename Struct, typename T, typename... Fields>
+    constexpr StructSchema<Struct, field<Struct, T>, Fields...> makeSchema(
+        const field<Struct, T>& first,
+        const Fields&... fields)
+    {
+        return StructSchema<Struct, field<Struct, T>, Fields...>(first, fields...);
+    }
 
 
-    /** Class responsible for parsing the command-line
-    *   input arguments. It receives the raw input data
-    *   and then parse it, returning a map
+    /** Fixed-capacity version of ArgumentParser, for
+    *   programs that can't allocate while starting up.
+    *
+    *   Up to N arguments can be registered at runtime, with
+    *   the same interface as ArgumentParser, but the names
+    *   and descriptions are kept as views (so they must
+    *   outlive the parser, as string literals do), and the
+    *   index and the results live in std::arrays inside the
+    *   parser. Registering arguments, parsing and checking
+    *   the results never touch the heap (only errors,
+    *   usage() and getArgument of heap types like
+    *   std::string do)
     */
-    class ArgumentParser
+    template <std::size_t N>
+    class StaticArgumentParser
     {
-    protected:
+    public:
+        /** Number of slots in the hash table
+        */
+        static constexpr std::size_t tableSize = detail::tableSizeFor(N);
 
-        /** Data structure to describe the basic
-        *   characteristics of an argument
-        *   (hasValue, description)
+    protected:
+        /** An expected argument
         */
-        typedef struct
-        {
-            /** Indicates if the argument is followed
-            *   by a value in command-line. E.g.:
-            *
-            *       program --integer 2
-            *
-            *   The argument "--integer" will contain
-            *   value 2
+        typedef struct{
+            /** Name of the argument
             */
-            bool hasValue;
+            std::string_view name;
 
-            /** String with the description of the argument.
-            *   It's used to show the usage os the program
-            *   in the terminal
+            /** Description of the argument
             */
-            std::string description;
+            std::string_view description;
+
+            /** Hash of the name, as given by detail::hashName
+            */
+            std::uint64_t hash;
+
+            /** Indicates if the argument is followed
+            *   by a value in command-line
+            */
+            bool hasValue;
         } argument_data;
 
-        /** map of the arguments registered in the class instance
+        /** Registered arguments, indexed by their handles
         */
-        std::map<std::string, argument_data> _argumentList;
+        std::array<argument_data, N> _arguments;
 
-        /** Map (argument name, argument value (if exists))
-        *   Arguments parsed from the inputs in the
-        *   current execution
+        /** Handles of the registered arguments sorted by
+        *   name, the order of the usage
         */
-        std::map<std::string, std::string> _parsedArguments;
+        std::array<std::uint32_t, N> sortedByName() const
+        {
+            std::array<std::uint32_t, N> sorted{};
+            for(std::size_t i = 0; i < this->_argumentCount; i++)
+                sorted[i] = static_cast<std::uint32_t>(i);
+            std::sort(sorted.begin(), sorted.begin() + this->_argumentCount, [this](auto a, auto b)
+            {
+                return this->_arguments[a].name < this->_arguments[b].name;
+            });
+            return sorted;
+        }
 
-        /** number of input arguments (argc - 1)
+        /** Number of registered arguments
         */
-        int _numberOfArguments;
+        std::size_t _argumentCount;
 
-        /** raw input arguments (argv)
+        /** Open-addressing hash table with linear probing,
+        *   holding (handle + 1) of the argument stored in
+        *   each slot, or 0 when empty
         */
-        char** _rawInput;
+        std::array<std::uint32_t, tableSize> _table;
 
-        /** Name of the current program
+        /** Pre-filter of the tokens that can be names
         */
-        std::string _programName;
+        detail::name_filter _filter;
 
-        /** State used to parse the argument and
-        *   its values
+        /** Views of the values, pointing into argv
         */
-        enum {
-            ARG_NAME=0,
-            ARG_VALUE
-        } _parseState;
+        std::array<std::string_view, N> _parsedValues;
 
-    public:
+        /** Indicates which arguments were given
+        */
+        std::array<bool, N> _parsedDefined;
 
+        /** Name of the program (argv[0])
+        */
+        std::string_view _programName;
 
-        /** Default constructor, used to redirect the input
-        *   arguments  directly to the class
+        /** Number of raw arguments
+        */
+        int _numberOfArguments;
+
+        /** Raw input
+        */
+        char** _rawInput;
+
+    public:
+
+        /** Constructor receiving the command-line input
         *
         *   @param argc
-        *       the same argc received as inputs to main.
-        *       It represents the number of command-line
-        *       arguments, including the program name
+        *       the same argc received as inputs to main
         *
         *   @param argv
-        *       also the argv received from main. It contains
-        *       an array of C-strings containing the input
-        *       arguments
+        *       the argv received from main. The results
+        *       point into it, so it must outlive the parser
         */
-        ArgumentParser(int argc, char** argv) :
-            _numberOfArguments(argc - 1),
-            _rawInput(argv),
-            _programName(std::string(argv[0]))
-        {
-        }
+        StaticArgumentParser(int argc, char** argv) :
+            _arguments(),
+            _argumentCount(0),
+            _table(),
+            _filter(),
+            _parsedValues(),
+            _parsedDefined(),
+            _programName(argc > 0 ? argv[0] : ""),
+            _numberOfArguments(argc),
+            _rawInput(argv)
+        { }
 
+        /** Constructor for a parser that only parses
+        *   the inputs given to parse(argc, argv)
+        *
+        *   @param programName
+        *       name of the program, shown in the usage
+        */
+        explicit StaticArgumentParser(std::string_view programName = std::string_view()) :
+            _arguments(),
+            _argumentCount(0),
+            _table(),
+            _filter(),
+            _parsedValues(),
+            _parsedDefined(),
+            _programName(programName),
+            _numberOfArguments(0),
+            _rawInput(nullptr)
+        { }
 
-        /** Includes a new expected command-line
-        *   argument to the map, and gives more information
-        *   about what is expected from it
+        /** Includes a new expected command-line argument.
+        *   Registering the same name again replaces its
+        *   data and keeps its handle
         *
         *   @param name
-        *       defines the name of the argument. If you need
-        *       the two dashes (--) as prefix to be expected
-        *       in the command-line you'll have to include it
-        *       in the name.
-        *
-        *       E.g.: program --debug (addArgument("--debug"))
+        *       name of the argument. Only the view is kept
         *
         *   @param hasValue
-        *       defines if the arguments receives an actual
-        *       value, or if its just a command-line flag.
-        *       If it has a value, the next argument in the
-        *       list will be taken as the value, otherwise
-        *       the value will be considered empty
+        *       defines if the argument requires a value
         *
         *   @param description
-        *       defines the description of the argument. Used
-        *       to be shown to the user as instruction in case
-        *       the "--help" flag is used
+        *       description of the argument. Only the view
+        *       is kept
+        *
+        *   @return the handle of the argument
+        *
+        *   @throws std::length_error
+        *       if N arguments were already registered
         */
-        void addArgument(
-            const std::string& name,
+        ArgHandle addArgument(
+            std::string_view name,
             bool hasValue = false,
-            const std::string& description = "")
+            std::string_view description = std::string_view())
         {
-            LOG("New Argument");
-            argument_data argData = { hasValue, description };
-            LOG_VAR(argData.hasValue);
-            LOG_VAR(argData.description);
-            this->_argumentList[name] = argData;
+            std::uint64_t hash = detail::hashName(name);
+            std::size_t slot = hash & (tableSize - 1);
+            for(;; slot = (slot + 1) & (tableSize - 1))
+            {
+                std::uint32_t item = this->_table[slot];
+                if(item == 0)
+                    break;
+
+                auto&& argument = this->_arguments[item - 1];
+                if(argument.hash == hash && argument.name == name)
+                {
+                    argument.hasValue = hasValue;
+                    argument.description = description;
+                    return ArgHandle{ item - 1 };
+                }
+            }
 
-            //for(auto&& arg : this->_argumentList)
-            //{
-            //    LOG_VAR(arg.first);
-            //    LOG_VAR(arg.second.hasValue);
-            //    LOG_VAR(arg.second.description);
-            //}
+            if(this->_argumentCount == N)
+                SIMPLE_ARG_PARSER_THROW(std::length_error("Too many arguments for the StaticArgumentParser"));
+
+            std::uint32_t index = static_cast<std::uint32_t>(this->_argumentCount++);
+            this->_arguments[index] = { name, description, hash, hasValue };
+            this->_table[slot] = index + 1;
+            this->_filter.add(name);
+            return ArgHandle{ index };
         }
 
-        /** Prints instructions of the program to the
-        *   terminal
+        /** Finds a registered argument
+        *
+        *   @param [in] argName
+        *       name of the argument
+        *
+        *   @return index of the argument (its handle), or -1
+        *       if it's unknown
         */
-        std::string usage() const
+        int findArgument(std::string_view argName) const
         {
-            std::stringstream ss;
+            if(!this->_filter.mayContain(argName))
+                return -1;
 
+            std::uint64_t hash = detail::hashName(argName);
+            for(std::size_t slot = hash & (tableSize - 1);; slot = (slot + 1) & (tableSize - 1))
+            {
+                std::uint32_t item = this->_table[slot];
+                if(item == 0)
+                    return -1;
 
-            ss << "  Usage:\n    ";
-            ss << this->_programName << " ";
-            for(auto&& arg : this->_argumentList)
+                auto&& argument = this->_arguments[item - 1];
+                if(argument.hash == hash && argument.name == argName)
+                    return static_cast<int>(item - 1);
+            }
+        }
+
+        /** Number of registered arguments
+        */
+        std::size_t size() const
+        {
+            return this->_argumentCount;
+        }
+
+        /** Returns the instructions of the program, in the
+        *   same format and order as ArgumentParser::usage
+        */
+        std::string usage() const
+        {
+            auto sorted = this->sortedByName();
+            return detail::usageText(this->_programName, [this, &sorted](auto&& visitor)
             {
-                ss<< "[ " << arg.first << " ";
-                if(arg.second.hasValue)
+                for(std::size_t i = 0; i < this->_argumentCount; i++)
                 {
-                    ss << "val";
+                    auto&& arg = this->_arguments[sorted[i]];
+                    visitor(arg.name, arg.hasValue, arg.description);
                 }
-                ss << "]  ";
-            }
-            ss << "\n\n";
+            });
+        }
 
-            for(auto&& arg : this->_argumentList)
+        /** Writes the instructions of the program straight
+        *   to a sink, wrapped to a number of columns, without
+        *   allocating. See Schema::writeUsage
+        *
+        *   @param sink
+        *       destination of the text (a std::ostream,
+        *       FILE*, std::string or caller buffer)
+        *
+        *   @param [in] width
+        *       number of columns, by default the width of
+        *       the terminal the sink writes to
+        *
+        *   @return length of the text
+        */
+        std::size_t writeUsage(
+            output_sink&& sink,
+            std::size_t width = output_sink::TERMINAL_WIDTH) const
+        {
+            auto sorted = this->sortedByName();
+            detail::writeUsageText(sink, this->_programName, width, [this, &sorted](auto&& visitor)
             {
-                if(!arg.second.description.empty())
+                for(std::size_t i = 0; i < this->_argumentCount; i++)
                 {
-                    ss<< "    [ " << arg.first << " ";
-                    if(arg.second.hasValue)
-                    {
-                        ss << "val";
-                    }
-                    ss << "] => " 
-                              << arg.second.description 
-                              << "\n\n";
+                    auto&& arg = this->_arguments[sorted[i]];
+                    visitor(arg.name, arg.hasValue, arg.description);
                 }
-            }
-            
-            ss << "\n\n";
-
-            return ss.str();
+            });
+            sink.flush();
+            return sink.written();
         }
 
-        /** Parses the raw command-line input and
-        *   updates a map with the name of the arguments
-        *   given and the strings of its values to be converted
+        /** Parses the input given to the constructor
+        *
+        *   @throws parser::parsing_exception
+        *       if an argument is not expected
         */
         void parse()
         {
-            auto state = ARG_NAME;
-            std::string name;
-            for(int _arg = 1; _arg <= _numberOfArguments; _arg++)
+            parse_status status = this->tryParse();
+            if(!status)
+                SIMPLE_ARG_PARSER_THROW(parser::parsing_exception(
+                    status.code, status.token, status.index, *this));
+        }
+
+        /** Parses the input given to the constructor,
+        *   returning the errors instead of throwing them
+        *
+        *   @return the outcome of the parse
+        */
+        parse_status tryParse()
+        {
+            LOG("Parsing arguments");
+            int name = -1;
+            for(int _arg = 1; _arg < this->_numberOfArguments; _arg++)
             {
-                std::string currentArg(this->_rawInput[_arg]);
-                auto argument = this->_argumentList.find(currentArg);
-                if(state == ARG_NAME)
+                std::string_view currentArg(this->_rawInput[_arg]);
+                if(name < 0)
                 {
-                    if(argument != this->_argumentList.end())
-                    {
-                        if(argument->second.hasValue)
-                        {
-                            state = ARG_VALUE;
-                            name = argument->first;
-                        }
-                        else
-                            this->_parsedArguments[argument->first] = "";
-                    }
+                    int argument = this->findArgument(currentArg);
+                    if(argument < 0)
+                        return parse_status{ parse_errc::unexpected_argument, _arg, currentArg };
+
+                    if(this->_arguments[argument].hasValue)
+                        name = argument;
                     else
-                    {
-                        std::stringstream msg;
-                        msg << "Argument '"
-                            << currentArg
-                            << "' not expected."
-                            << "\n";
-
-                        parser::parsing_exception error(
-                            msg.str(),
-                            this->usage()
-                            );
-
-                        throw error;
-                    }
+                        this->_parsedDefined[argument] = true;
                 }
-                else if(state == ARG_VALUE)
+                else
                 {
-                    LOG("parsing argument value");
-                    std::string data(this->_rawInput[_arg]);
-                    LOG_VAR(data);
-
-                    this->_parsedArguments[name] = data;
-                    LOG("access");
-                    LOG_VAR(this->_parsedArguments[name]);
-                    state = ARG_NAME;
+                    this->_parsedDefined[name] = true;
+                    this->_parsedValues[name] = currentArg;
+                    name = -1;
                 }
             }
+            if(name >= 0)
+            {
+                int last = this->_numberOfArguments - 1;
+                return parse_status{ parse_errc::missing_value, last, std::string_view(this->_rawInput[last]) };
+            }
+            return parse_status{ parse_errc(), -1, std::string_view() };
+        }
+
+        /** Parses a new command-line input, replacing the
+        *   results of the previous one
+        *
+        *   @param argc
+        *       number of raw arguments
+        *
+        *   @param argv
+        *       raw input. The results point into it, so it
+        *       must outlive them
+        *
+        *   @throws parser::parsing_exception
+        *       if an argument is not expected
+        */
+        void parse(int argc, char** argv)
+        {
+            parse_status status = this->tryParse(argc, argv);
+            if(!status)
+                SIMPLE_ARG_PARSER_THROW(parser::parsing_exception(
+                    status.code, status.token, status.index, *this));
         }
 
+        /** Parses a new command-line input, replacing the
+        *   results of the previous one and returning the
+        *   errors instead of throwing them
+        *
+        *   @param argc
+        *       number of raw arguments
+        *
+        *   @param argv
+        *       raw input. The results point into it, so it
+        *       must outlive them
+        *
+        *   @return the outcome of the parse
+        */
+        parse_status tryParse(int argc, char** argv)
+        {
+            this->_numberOfArguments = argc;
+            this->_rawInput = argv;
+            this->_parsedValues.fill(std::string_view());
+            this->_parsedDefined.fill(false);
+            return this->tryParse();
+        }
 
-        /** Verifies if a giver argument is defined
+        /** Verifies if a given argument is defined
+        *
+        *   @param [in] handle
+        *       handle returned by addArgument
+        */
+        bool isDefined(ArgHandle handle) const
+        {
+            return handle.index < this->_argumentCount && this->_parsedDefined[handle.index];
+        }
+
+        /** Verifies if a given argument is defined
         *
         *   @param [in] argName
         *       name of the argument to be verified
         */
-        bool isDefined(const std::string& argName) const
+        bool isDefined(std::string_view argName) const
         {
-            auto& args = this->_parsedArguments;
-            //std::cerr << args.find(argName)->second << std::endl; 
-            return args.find(argName) != args.end();
+            int index = this->findArgument(argName);
+            return index >= 0 && this->_parsedDefined[index];
         }
 
+        /** Verifies if a given argument is defined and
+        *   contains an extra value
+        *
+        *   @param [in] handle
+        *       handle returned by addArgument
+        */
+        bool hasValue(ArgHandle handle) const
+        {
+            return this->isDefined(handle) && this->_arguments[handle.index].hasValue;
+        }
 
-        /** Verifies if a given argument constains an extra
-        *   value
+        /** Verifies if a given argument is defined and
+        *   contains an extra value
         *
         *   @param [in] argName
         *       name of the argument to be verified
         */
-        bool hasValue(const std::string& argName) const
+        bool hasValue(std::string_view argName) const
         {
-            auto& args = this->_parsedArguments;
-            auto argument = args.find(argName);
+            int index = this->findArgument(argName);
+            return index >= 0 && this->hasValue(ArgHandle{ static_cast<std::uint32_t>(index) });
+        }
 
-            bool ret = false;
+        /** Retrieve the raw argument value, or an empty view
+        *
+        *   @param [in] handle
+        *       handle returned by addArgument
+        */
+        std::string_view getArgumentView(ArgHandle handle) const
+        {
+            return this->isDefined(handle) ? this->_parsedValues[handle.index] : std::string_view();
+        }
 
-            if(argument != args.end())
-            {
-                auto&& argumentData = this->_argumentList.find(argName);
-                ret = argumentData->second.hasValue;
-            }
+        /** Retrieve the raw argument value, or an empty view
+        *
+        *   @param [in] argName
+        *       name of the argument to be retrieved
+        */
+        std::string_view getArgumentView(std::string_view argName) const
+        {
+            int index = this->findArgument(argName);
+            return index >= 0 ? this->_parsedValues[index] : std::string_view();
+        }
 
-            return ret;
+        /** Retrieve the argument value, converted to T
+        *   by parser::convert
+        *
+        *   @param [in] handle
+        *       handle returned by addArgument
+        *
+        *   @throws parser::conversion_exception
+        *       if the argument was not defined, or if its
+        *       value is malformed or out of range for T
+        */
+        template <typename T>
+        T getArgument(ArgHandle handle) const
+        {
+            return detail::convertArgument<T>(
+                handle.index < this->_argumentCount
+                    ? this->_arguments[handle.index].name : std::string_view(),
+                this->isDefined(handle),
+                this->getArgumentView(handle));
         }
 
-        // TODO: Add check for correct datatype format
-        /** Retrieve the argument value
+        /** Retrieve the argument value, converted to T
+        *   by parser::convert
         *
         *   @param [in] argName
-        *       name of the argument to be verified
+        *       name of the argument to be retrieved
+        *
+        *   @throws parser::conversion_exception
+        *       if the argument was not defined, or if its
+        *       value is malformed or out of range for T
         */
         template <typename T>
-        T getArgument(const std::string& argName) const
+        T getArgument(std::string_view argName) const
         {
-            std::stringstream ss;
-            ss << this->_parsedArguments.find(argName)->second;
-            T value;
-            ss >> value;
-            return value;
+            return detail::convertArgument<T>(
+                argName,
+                this->isDefined(argName),
+                this->getArgumentView(argName));
         }
-
     };
 
 }
@@ -0,0 +1,89 @@
+// Measures how Schema::parseBatch scales with the number of threads.
+// The results are printed as JSON.
+#include "../SimpleArgParser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+int main(int argc, char** argv)
+{
+    parser::ArgumentParser argParser(argc, argv);
+    argParser.addArgument("--lines", true, "Number of command-lines (default 200000)");
+    argParser.addArgument("--options", true, "Number of registered arguments (default 200)");
+
+    try
+    {
+        argParser.parse();
+    }
+    catch(parser::parsing_exception& e)
+    {
+        std::fprintf(stderr, "%s", e.message().c_str());
+        return 1;
+    }
+
+    std::size_t lineCount = argParser.isDefined("--lines") ?
+        argParser.getArgument<std::size_t>("--lines") : 200000;
+    std::size_t optionCount = argParser.isDefined("--options") ?
+        argParser.getArgument<std::size_t>("--options") : 200;
+
+    // Half of the arguments are flags, the others have values
+    std::vector<std::string> names;
+    parser::Schema schema("bench_batch");
+    for(std::size_t i = 0; i < optionCount; i++)
+    {
+        names.push_back("--option-" + std::to_string(i));
+        schema.addArgument(names.back(), i % 2 == 1);
+    }
+    schema.freeze();
+
+    // Every line has 8 arguments; one in ten lines is invalid
+    static char value[] = "42";
+    static char unknown[] = "--unknown";
+    std::vector<std::vector<char*>> storage(lineCount);
+    std::vector<parser::command_line> lines(lineCount);
+    for(std::size_t line = 0; line < lineCount; line++)
+    {
+        auto&& args = storage[line];
+        args.push_back(argv[0]);
+        for(std::size_t k = 0; k < 8; k++)
+        {
+            std::size_t index = (line * 7 + k * 13) % optionCount;
+            args.push_back(&names[index][0]);
+            if(index % 2 == 1)
+                args.push_back(value);
+        }
+        if(line % 10 == 0)
+            args.push_back(unknown);
+        lines[line] = { static_cast<int>(args.size()), args.data() };
+    }
+
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts;
+    for(unsigned threads = 1; threads < hardware; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(hardware);
+
+    std::printf("{\n  \"benchmark\": \"batch\",\n  \"lines\": %zu,\n  \"options\": %zu,\n  \"results\": [",
+        lineCount, optionCount);
+    for(std::size_t i = 0; i < threadCounts.size(); i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto entries = schema.parseBatch(lines, threadCounts[i]);
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::size_t failures = 0;
+        for(auto&& entry : entries)
+            failures += !entry.status;
+
+        std::printf("%s\n    {\"threads\": %u, \"lines_per_second\": %.0f, \"failures\": %zu}",
+            i == 0 ? "" : ",", threadCounts[i], lineCount / seconds, failures);
+    }
+    std::printf("\n  ]\n}\n");
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Compares the stringstream conversion previously used by
+// ArgumentParser::getArgument<T> with parser::convert
+#include "../SimpleArgParser.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/** Conversion path used by getArgument<T> before parser::convert
+*/
+template <typename T>
+T legacyConvert(const std::string& text)
+{
+    std::stringstream ss;
+    ss << text;
+    T value;
+    ss >> value;
+    return value;
+}
+
+
+template <typename T>
+T fastConvert(const std::string& text)
+{
+    T value{};
+    parser::convert(text, value);
+    return value;
+}
+
+
+/** Bits of a converted value, folded into the sink so
+*   the conversions aren't optimized away. Adding the values
+*   themselves could overflow (undefined for signed types)
+*/
+template <typename T>
+std::uint64_t bitsOf(T value)
+{
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(value));
+    return bits;
+}
+
+
+/** Runs f over all the inputs several times and returns
+*   the average nanoseconds per conversion
+*/
+template <typename T, typename F>
+double measure(const std::vector<std::string>& inputs, int rounds, F f)
+{
+    volatile std::uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int round = 0; round < rounds; round++)
+        for(auto&& text : inputs)
+            sink = sink ^ bitsOf<T>(f(text));
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns / (double(rounds) * inputs.size());
+}
+
+
+template <typename T>
+void run(const char* typeName, const std::vector<std::string>& inputs, int rounds)
+{
+    double legacy = measure<T>(inputs, rounds, legacyConvert<T>);
+    double fast = measure<T>(inputs, rounds, fastConvert<T>);
+    std::printf("%-8s %14.2f %14.2f %9.1fx\n",
+        typeName, legacy, fast, legacy / fast);
+}
+
+
+int main()
+{
+    const int count = 10000;
+    const int rounds = 50;
+
+    std::vector<std::string> integers;
+    std::vector<std::string> reals;
+    for(int i = 0; i < count; i++)
+    {
+        integers.push_back(std::to_string(i * 7919 - 4000000));
+        reals.push_back(std::to_string(i * 0.731 - 3000.0));
+    }
+
+    std::printf("%-8s %14s %14s %10s\n",
+        "type", "sstream ns/op", "convert ns/op", "speedup");
+    run<int>("int", integers, rounds);
+    run<float>("float", reals, rounds);
+    run<double>("double", reals, rounds);
+
+    return 0;
+}
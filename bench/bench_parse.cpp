@@ -0,0 +1,258 @@
+// Measures how ArgumentParser scales with the number of registered
+// arguments, the number of tokens and the mix of flags and values.
+// The results are printed as JSON, to be compared across releases.
+#include "../SimpleArgParser.hpp"
+
+#include <malloc.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /** Heap statistics, updated by the global operator new/delete.
+    *   The sizes are the usable sizes of the blocks, as reported
+    *   by malloc_usable_size, so nothing is stored around them
+    */
+    std::size_t allocations = 0;
+    std::size_t liveBytes = 0;
+    std::size_t peakBytes = 0;
+}
+
+
+void* operator new(std::size_t size)
+{
+    void* block = std::malloc(size != 0 ? size : 1);
+    if(block == nullptr)
+        throw std::bad_alloc();
+
+    allocations++;
+    liveBytes += malloc_usable_size(block);
+    peakBytes = std::max(peakBytes, liveBytes);
+    return block;
+}
+
+
+// Not inlined, or GCC pairs the free() with the new expressions of
+// the callers and warns about mismatched allocation functions
+[[gnu::noinline]] void operator delete(void* pointer) noexcept
+{
+    if(pointer == nullptr)
+        return;
+
+    liveBytes -= malloc_usable_size(pointer);
+    std::free(pointer);
+}
+
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    double elapsedNs(clock_type::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+    }
+
+
+    /** Command-line generated for a benchmark case. The
+    *   arguments with even indices are flags and the odd
+    *   ones have values
+    */
+    struct command_line
+    {
+        std::vector<std::string> names;
+        std::vector<char*> argv;
+    };
+
+
+    command_line makeCommandLine(std::size_t schemaSize, std::size_t tokens, double valueRatio)
+    {
+        static char program[] = "bench_parse";
+        static char value[] = "42";
+
+        command_line input;
+        input.names.reserve(schemaSize);
+        for(std::size_t i = 0; i < schemaSize; i++)
+            input.names.push_back("--option-" + std::to_string(i));
+
+        std::mt19937_64 random(schemaSize * 31 + tokens);
+        std::bernoulli_distribution takesValue(valueRatio);
+        std::uniform_int_distribution<std::size_t> pick(0, (schemaSize - 1) / 2);
+
+        input.argv.reserve(tokens + 1);
+        input.argv.push_back(program);
+        while(input.argv.size() <= tokens)
+        {
+            bool withValue = takesValue(random) && input.argv.size() < tokens && schemaSize > 1;
+            std::size_t index = 2 * pick(random) + (withValue ? 1 : 0);
+            if(index >= schemaSize)
+                index = withValue ? 1 : 0;
+
+            input.argv.push_back(&input.names[index][0]);
+            if(withValue)
+                input.argv.push_back(value);
+        }
+        return input;
+    }
+
+
+    void runCase(std::size_t schemaSize, std::size_t tokens, double valueRatio,
+                 int repetitions, bool first)
+    {
+        command_line input = makeCommandLine(schemaSize, tokens, valueRatio);
+        int argc = static_cast<int>(input.argv.size());
+
+        std::size_t baseBytes = liveBytes;
+        peakBytes = liveBytes;
+
+        parser::ArgumentParser argParser(argc, input.argv.data());
+
+        std::vector<parser::ArgHandle> handles;
+        handles.reserve(schemaSize);
+
+        auto start = clock_type::now();
+        std::size_t before = allocations;
+        for(std::size_t i = 0; i < schemaSize; i++)
+            handles.push_back(argParser.addArgument(input.names[i], i % 2 == 1));
+        double addNs = elapsedNs(start);
+        std::size_t addAllocations = allocations - before;
+
+        start = clock_type::now();
+        argParser.freeze();
+        double freezeNs = elapsedNs(start);
+
+        // Repeated parses of the same input: the fastest one
+        // is reported, as well as the allocations of the last
+        double parseNs = 0;
+        std::size_t parseAllocations = 0;
+        for(int rep = 0; rep < repetitions; rep++)
+        {
+            before = allocations;
+            start = clock_type::now();
+            argParser.parse();
+            double ns = elapsedNs(start);
+            parseAllocations = allocations - before;
+            parseNs = rep == 0 ? ns : std::min(parseNs, ns);
+        }
+
+        // Lookups of all the registered names
+        std::size_t defined = 0;
+        before = allocations;
+        start = clock_type::now();
+        for(auto&& name : input.names)
+            defined += argParser.isDefined(name);
+        double isDefinedNs = elapsedNs(start) / schemaSize;
+        std::size_t isDefinedAllocations = allocations - before;
+
+        std::size_t definedByHandle = 0;
+        start = clock_type::now();
+        for(auto handle : handles)
+            definedByHandle += argParser.isDefined(handle);
+        double isDefinedHandleNs = elapsedNs(start) / schemaSize;
+
+        std::vector<parser::ArgHandle> valued;
+        for(std::size_t i = 1; i < schemaSize; i += 2)
+            if(argParser.isDefined(handles[i]))
+                valued.push_back(handles[i]);
+
+        long long sum = 0;
+        before = allocations;
+        start = clock_type::now();
+        for(auto handle : valued)
+            sum += argParser.getArgument<int>(input.names[handle.index]);
+        double getArgumentNs = valued.empty() ? 0 : elapsedNs(start) / valued.size();
+        std::size_t getArgumentAllocations = allocations - before;
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        std::printf(
+            "%s\n    {\"schema_size\": %zu, \"tokens\": %zu, \"value_ratio\": %.2f, "
+            "\"add_argument_ns_per_option\": %.2f, \"add_argument_allocations\": %zu, "
+            "\"freeze_ns_per_option\": %.2f, "
+            "\"parse_ns_per_token\": %.2f, \"parse_allocations\": %zu, "
+            "\"is_defined_ns\": %.2f, \"is_defined_allocations\": %zu, "
+            "\"is_defined_handle_ns\": %.2f, "
+            "\"get_argument_ns\": %.2f, \"get_argument_allocations\": %zu, "
+            "\"defined\": %zu, \"defined_by_handle\": %zu, \"checksum\": %lld, "
+            "\"peak_heap_bytes\": %zu, \"max_rss_kb\": %ld}",
+            first ? "" : ",",
+            schemaSize, tokens, valueRatio,
+            addNs / schemaSize, addAllocations,
+            freezeNs / schemaSize,
+            tokens > 0 ? parseNs / tokens : 0.0, parseAllocations,
+            isDefinedNs, isDefinedAllocations,
+            isDefinedHandleNs,
+            getArgumentNs, getArgumentAllocations,
+            defined, definedByHandle, sum,
+            peakBytes - baseBytes, usage.ru_maxrss);
+        std::fflush(stdout);
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    parser::ArgumentParser argParser(argc, argv);
+    argParser.addArgument("--max-schema", true, "Largest number of arguments (default 100000)");
+    argParser.addArgument("--max-tokens", true, "Largest number of tokens (default 1000000)");
+    argParser.addArgument("--repetitions", true, "Parses of each case (default 5)");
+
+    try
+    {
+        argParser.parse();
+    }
+    catch(parser::parsing_exception& e)
+    {
+        std::fprintf(stderr, "%s", e.message().c_str());
+        return 1;
+    }
+
+    std::size_t maxSchema = argParser.isDefined("--max-schema") ?
+        argParser.getArgument<std::size_t>("--max-schema") : 100000;
+    std::size_t maxTokens = argParser.isDefined("--max-tokens") ?
+        argParser.getArgument<std::size_t>("--max-tokens") : 1000000;
+    int repetitions = argParser.isDefined("--repetitions") ?
+        argParser.getArgument<int>("--repetitions") : 5;
+
+    const std::size_t schemaSizes[] = { 10, 100, 1000, 10000, 100000 };
+    const std::size_t tokenCounts[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+    const double valueRatios[] = { 0.0, 0.5, 1.0 };
+
+    std::printf("{\n  \"benchmark\": \"parse\",\n  \"results\": [");
+    bool first = true;
+    for(auto schemaSize : schemaSizes)
+    {
+        if(schemaSize > maxSchema)
+            continue;
+        for(auto tokens : tokenCounts)
+        {
+            if(tokens > maxTokens)
+                continue;
+            for(auto valueRatio : valueRatios)
+            {
+                runCase(schemaSize, tokens, valueRatio, repetitions, first);
+                first = false;
+            }
+        }
+    }
+    std::printf("\n  ]\n}\n");
+
+    return 0;
+}
@@ -0,0 +1,3 @@
+g++ -std=c++17 -O2 bench_conversion.cpp -I. -o bench_conversion
+g++ -std=c++17 -O2 bench_parse.cpp -I. -o bench_parse
+g++ -std=c++17 -O2 -pthread bench_batch.cpp -I. -o bench_batch
@@ -0,0 +1,3 @@
+./bench_conversion
+./bench_parse > bench_parse.json
+./bench_batch > bench_batch.json
@@ -0,0 +1,71 @@
+#ifndef _ALLOC_COUNTER_
+#define _ALLOC_COUNTER_
+
+/** Replaces the global operator new/delete with versions
+*   counting the allocations, so the tests can check that
+*   a piece of code doesn't touch the heap. It defines the
+*   replacement functions, so it must be included by only
+*   one translation unit of the test program
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace alloc_counter
+{
+    /** Number of calls to operator new since the
+    *   program started
+    */
+    inline std::atomic<std::size_t> allocations{0};
+
+    /** Counts the allocations made while it's alive. E.g.:
+    *
+    *       alloc_counter::scope scope;
+    *       parser.parse();
+    *       REQUIRE(scope.count() == 0);
+    */
+    class scope
+    {
+    protected:
+        /** Allocations made before the scope
+        */
+        std::size_t _start;
+
+    public:
+        scope() : _start(allocations.load())
+        { }
+
+        /** Allocations made since the scope was created
+        */
+        std::size_t count() const
+        {
+            return allocations.load() - this->_start;
+        }
+    };
+}
+
+
+void* operator new(std::size_t size)
+{
+    alloc_counter::allocations++;
+    void* block = std::malloc(size != 0 ? size : 1);
+    if(block == nullptr)
+        throw std::bad_alloc();
+    return block;
+}
+
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+#endif // _ALLOC_COUNTER_
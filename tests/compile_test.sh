@@ -1 +1,2 @@
-g++ test_arg_parser.cpp -I. -o test_arg_parser
+g++ -std=c++17 -pthread -DCATCH_CONFIG_NO_POSIX_SIGNALS test_arg_parser.cpp -I. -o test_arg_parser
+g++ -std=c++17 -pthread -DCATCH_CONFIG_NO_POSIX_SIGNALS test_alloc_budget.cpp -I. -o test_alloc_budget
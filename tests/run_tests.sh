@@ -1 +1 @@
-./test_arg_parser
+./test_arg_parser && ./test_alloc_budget
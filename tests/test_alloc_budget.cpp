@@ -0,0 +1,308 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "../SimpleArgParser.hpp"
+#include "alloc_counter.hpp"
+
+#include <cstdio>
+#include <string>
+
+
+/** Allocation budgets of the hot paths. Each check counts
+*   the calls to operator new made by one operation, and
+*   compares it to the exact number expected, so a stray
+*   temporary (or a saved one) shows up here. The counts
+*   are taken before any assertion, as Catch allocates
+*/
+
+namespace
+{
+    /** Parser with the arguments used by all the tests
+    */
+    struct budget_parser
+    {
+        parser::ArgumentParser argParser;
+        parser::ArgHandle size;
+        parser::ArgHandle mass;
+        parser::ArgHandle name;
+        parser::ArgHandle debug;
+        parser::ArgHandle verbose;
+
+        budget_parser(int argc, char** argv) :
+            argParser(argc, argv),
+            size(argParser.addArgument("--size", true, "Size of the given vector")),
+            mass(argParser.addArgument("--mass", true, "Mass of that thing")),
+            name(argParser.addArgument("--name", true, "Name of the user")),
+            debug(argParser.addArgument("--debug", false, "for debug messages")),
+            verbose(argParser.addArgument("-v"))
+        { }
+    };
+
+    /** Allocations made by an operation
+    */
+    template <typename Operation>
+    std::size_t allocationsOf(Operation operation)
+    {
+        alloc_counter::scope scope;
+        operation();
+        return scope.count();
+    }
+
+    char *emptyArgv[] = {
+        "program"
+    };
+
+    char *flagsArgv[] = {
+        "program",
+        "--debug",
+        "-v"
+    };
+
+    char *valuesArgv[] = {
+        "program",
+        "--size",
+        "12",
+        "--mass",
+        "35.5",
+        "--name",
+        "John"
+    };
+
+    char *mixedArgv[] = {
+        "program",
+        "--debug",
+        "--size",
+        "12",
+        "-v",
+        "--name",
+        "a name long enough to skip the small string buffer"
+    };
+
+    char *wrongArgv[] = {
+        "program",
+        "--size",
+        "12",
+        "--wrong"
+    };
+}
+
+
+TEST_CASE("Allocation budget of parse")
+{
+
+    SECTION("The first parse builds the index and the results"){
+
+        budget_parser empty(1, emptyArgv);
+        budget_parser mixed(7, mixedArgv);
+
+        std::size_t emptyCount = allocationsOf([&]{ empty.argParser.parse(); });
+        std::size_t mixedCount = allocationsOf([&]{ mixed.argParser.parse(); });
+
+        // Frozen arguments, hash table, sorted names, values,
+        // flags and counts, whatever the input is, plus the
+        // block, texts and entries of the usage model shared
+        // with the exceptions
+        REQUIRE(emptyCount == 9);
+        REQUIRE(mixedCount == 9);
+    }
+
+    SECTION("Reusing the parser allocates nothing"){
+
+        budget_parser parser(1, emptyArgv);
+        parser.argParser.parse();
+
+        std::size_t flagsCount = allocationsOf([&]{ parser.argParser.parse(3, flagsArgv); });
+        std::size_t valuesCount = allocationsOf([&]{ parser.argParser.parse(7, valuesArgv); });
+        std::size_t mixedCount = allocationsOf([&]{ parser.argParser.parse(7, mixedArgv); });
+
+        REQUIRE(flagsCount == 0);
+        REQUIRE(valuesCount == 0);
+        REQUIRE(mixedCount == 0);
+    }
+
+    SECTION("Large values are never copied"){
+
+        std::string blob(256 * 1024, 'x');
+        char *blobArgv[] = { "program", "--name", &blob[0], "--size", "12" };
+
+        budget_parser parser(1, emptyArgv);
+        parser.argParser.parse();
+
+        std::size_t blobCount = allocationsOf([&]{ parser.argParser.parse(5, blobArgv); });
+        std::string_view name = parser.argParser.getArgumentView(parser.name);
+
+        // The values are views into argv, stored in a slot
+        // per argument, so there's nothing to allocate
+        REQUIRE(blobCount == 0);
+        REQUIRE(name.data() == blob.data());
+        REQUIRE(name.size() == blob.size());
+    }
+
+    SECTION("Rejecting an input"){
+
+        budget_parser parser(1, emptyArgv);
+        parser.argParser.parse();
+
+        std::size_t statusCount = allocationsOf([&]{ parser.argParser.tryParse(4, wrongArgv); });
+        std::size_t exceptionCount = allocationsOf([&]
+        {
+            try
+            {
+                parser.argParser.parse(4, wrongArgv);
+            }
+            catch(parser::parsing_exception&)
+            { }
+        });
+
+        REQUIRE(statusCount == 0);
+        // Only the fixed message of std::runtime_error: the
+        // message is written into a buffer inside the
+        // exception, and the usage is rendered on demand
+        REQUIRE(exceptionCount == 1);
+    }
+
+    SECTION("Lists of values share one buffer"){
+
+        std::vector<std::string> files;
+        for(int i = 0; i < 100000; i++)
+            files.push_back("file" + std::to_string(i));
+
+        std::vector<char*> argv = { const_cast<char*>("program"), const_cast<char*>("--files") };
+        for(auto&& file : files)
+            argv.push_back(const_cast<char*>(file.c_str()));
+
+        parser::Schema schema("program");
+        auto filesArg = schema.addArgument("--files", parser::arity::oneOrMore());
+        schema.freeze();
+        parser::ParseResult result(schema);
+
+        std::size_t firstCount = allocationsOf([&]{ schema.parse(int(argv.size()), argv.data(), result); });
+        result.clear();
+        std::size_t reuseCount = allocationsOf([&]{ schema.parse(int(argv.size()), argv.data(), result); });
+
+        // Only the growth of the two shared buffers, never
+        // an allocation per value
+        REQUIRE(firstCount < 64);
+        REQUIRE(reuseCount == 0);
+        REQUIRE(result.values(filesArg).size() == files.size());
+    }
+
+    SECTION("Passing foreign tokens through"){
+
+        std::vector<std::string> tokens;
+        for(int i = 0; i < 10000; i++)
+            tokens.push_back(i % 2 == 0 ? "--foreign-" + std::to_string(i) : "value");
+
+        std::vector<char*> argv = { const_cast<char*>("program") };
+        for(auto&& token : tokens)
+            argv.push_back(const_cast<char*>(token.c_str()));
+
+        parser::Schema schema("program");
+        schema.addArgument("--size", true);
+        schema.enablePassthrough();
+        schema.freeze();
+        parser::ParseResult result(schema);
+
+        std::size_t firstCount = allocationsOf([&]{ schema.parse(int(argv.size()), argv.data(), result); });
+        result.clear();
+        std::size_t reuseCount = allocationsOf([&]{ schema.parse(int(argv.size()), argv.data(), result); });
+
+        // All of them are merged into one range
+        REQUIRE(firstCount == 1);
+        REQUIRE(reuseCount == 0);
+        REQUIRE(result.passthrough().size() == 1);
+    }
+}
+
+
+TEST_CASE("Allocation budget of the accessors")
+{
+
+    budget_parser parser(7, mixedArgv);
+    parser.argParser.parse();
+    auto&& argParser = parser.argParser;
+
+    std::size_t definedCount = allocationsOf([&]
+    {
+        argParser.isDefined("--debug");
+        argParser.isDefined("--mass");
+        argParser.isDefined("--unknown");
+        argParser.isDefined(parser.debug);
+        argParser.isDefined(parser.mass);
+    });
+
+    std::size_t valueCount = allocationsOf([&]
+    {
+        argParser.hasValue("--size");
+        argParser.hasValue("--debug");
+        argParser.hasValue(parser.size);
+        argParser.hasValue(parser.debug);
+    });
+
+    std::size_t numberCount = allocationsOf([&]
+    {
+        argParser.getArgument<int>("--size");
+        argParser.getArgument<double>(parser.size);
+    });
+
+    std::size_t viewCount = allocationsOf([&]{ argParser.getArgumentView(parser.name); });
+    std::size_t stringCount = allocationsOf([&]{ argParser.getArgument<std::string>(parser.name); });
+    std::size_t shortStringCount = allocationsOf([&]{ argParser.getArgument<std::string>(parser.size); });
+
+    REQUIRE(definedCount == 0);
+    REQUIRE(valueCount == 0);
+    REQUIRE(numberCount == 0);
+    REQUIRE(viewCount == 0);
+    // Just the copy of the value (short values fit in the
+    // small string buffer)
+    REQUIRE(stringCount == 1);
+    REQUIRE(shortStringCount == 0);
+}
+
+
+TEST_CASE("Allocation budget of usage")
+{
+
+    budget_parser parser(1, emptyArgv);
+    parser.argParser.parse();
+
+    std::size_t usageCount = allocationsOf([&]{ parser.argParser.usage(); });
+
+    char buffer[4096];
+    std::size_t bufferCount = allocationsOf([&]{ parser.argParser.writeUsage({ buffer, sizeof(buffer) }, 40); });
+    std::size_t fileCount = allocationsOf([&]
+    {
+        std::FILE* file = std::tmpfile();
+        parser.argParser.writeUsage(file, 40);
+        std::fclose(file);
+    });
+
+    // Just the returned string, measured beforehand
+    REQUIRE(usageCount == 1);
+    // Streaming doesn't allocate at all
+    REQUIRE(bufferCount == 0);
+    REQUIRE(fileCount == 0);
+}
+
+
+TEST_CASE("Allocation budget of StaticArgumentParser")
+{
+
+    std::size_t count = allocationsOf([]
+    {
+        parser::StaticArgumentParser<8> argParser(7, valuesArgv);
+        auto size = argParser.addArgument("--size", true, "Size of the given vector");
+        auto mass = argParser.addArgument("--mass", true, "Mass of that thing");
+        argParser.addArgument("--name", true, "Name of the user");
+        argParser.addArgument("--debug", false, "for debug messages");
+        argParser.parse();
+
+        argParser.isDefined("--debug");
+        argParser.hasValue(mass);
+        argParser.getArgumentView("--name");
+        argParser.getArgument<int>(size);
+        argParser.getArgument<double>(mass);
+    });
+
+    // Registering, parsing and reading all stay on the stack
+    REQUIRE(count == 0);
+}
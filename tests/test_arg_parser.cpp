@@ -2,6 +2,11 @@
 #include "catch2/catch.hpp"
 #include "../SimpleArgParser.hpp"
 
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
 
 TEST_CASE("Testing wrong value")
 {
@@ -156,3 +161,2118 @@ TEST_CASE("Testing expected flag with value")
 }
 
 
+TEST_CASE("Testing zero-copy argument views")
+{
+
+    SECTION("Value view points into argv"){
+
+        int argc = 4;
+
+        char *argv[] = {
+            "program",
+            "--path",
+            "/some/very/long/path/to/a/file.dat",
+            "--debug"
+        };
+
+        parser::ArgumentParser argParser(argc, argv);
+
+        argParser.addArgument("--path", true, "Input path");
+        argParser.addArgument("--debug", false, "for debug messages");
+
+        argParser.parse();
+
+        auto path = argParser.getArgumentView("--path");
+
+        REQUIRE(path == "/some/very/long/path/to/a/file.dat");
+        // No copy is made: the view shares the argv storage
+        REQUIRE(path.data() == argv[2]);
+
+        REQUIRE(argParser.getArgumentView("--debug").empty());
+        REQUIRE(argParser.getArgument<std::string>("--path") == std::string(path));
+    }
+
+    SECTION("Undefined argument gives an empty view"){
+
+        int argc = 1;
+
+        char *argv[] = {
+            "program"
+        };
+
+        parser::ArgumentParser argParser(argc, argv);
+        argParser.addArgument("--path", true, "Input path");
+        argParser.parse();
+
+        REQUIRE(argParser.getArgumentView("--path").empty());
+    }
+}
+
+TEST_CASE("Testing value conversion")
+{
+
+    SECTION("Values are fully converted"){
+
+        int argc = 9;
+
+        char *argv[] = {
+            "program",
+            "--name",
+            "hello world",
+            "--count",
+            "-42",
+            "--ratio",
+            "+1.5e3",
+            "--verbose",
+            "true"
+        };
+
+        parser::ArgumentParser argParser(argc, argv);
+
+        argParser.addArgument("--name", true);
+        argParser.addArgument("--count", true);
+        argParser.addArgument("--ratio", true);
+        argParser.addArgument("--verbose", true);
+
+        argParser.parse();
+
+        // Strings are no longer truncated at the first space
+        REQUIRE(argParser.getArgument<std::string>("--name") == "hello world");
+        REQUIRE(argParser.getArgument<std::string_view>("--name") == "hello world");
+        REQUIRE(argParser.getArgument<int>("--count") == -42);
+        REQUIRE(argParser.getArgument<long long>("--count") == -42);
+        REQUIRE(argParser.getArgument<double>("--ratio") == 1500.0);
+        REQUIRE(argParser.getArgument<bool>("--verbose"));
+    }
+
+    SECTION("Malformed values are reported"){
+
+        int argc = 7;
+
+        char *argv[] = {
+            "program",
+            "--size",
+            "12abc",
+            "--mass",
+            "heavy",
+            "--count",
+            "-1"
+        };
+
+        parser::ArgumentParser argParser(argc, argv);
+
+        argParser.addArgument("--size", true);
+        argParser.addArgument("--mass", true);
+        argParser.addArgument("--count", true);
+        argParser.addArgument("--debug", false);
+
+        argParser.parse();
+
+        REQUIRE_THROWS_AS(argParser.getArgument<int>("--size"), parser::conversion_exception);
+        REQUIRE_THROWS_AS(argParser.getArgument<double>("--mass"), parser::conversion_exception);
+        REQUIRE_THROWS_AS(argParser.getArgument<unsigned>("--count"), parser::conversion_exception);
+        REQUIRE_THROWS_AS(argParser.getArgument<int>("--debug"), parser::conversion_exception);
+    }
+
+    SECTION("Overflow is detected"){
+
+        int argc = 5;
+
+        char *argv[] = {
+            "program",
+            "--small",
+            "300",
+            "--huge",
+            "1e400"
+        };
+
+        parser::ArgumentParser argParser(argc, argv);
+
+        argParser.addArgument("--small", true);
+        argParser.addArgument("--huge", true);
+
+        argParser.parse();
+
+        REQUIRE(argParser.getArgument<int>("--small") == 300);
+
+        try
+        {
+            argParser.getArgument<signed char>("--small");
+            FAIL("signed char overflow not detected");
+        }
+        catch(parser::conversion_exception& e)
+        {
+            REQUIRE(e.code() == std::errc::result_out_of_range);
+        }
+
+        REQUIRE_THROWS_AS(argParser.getArgument<double>("--huge"), parser::conversion_exception);
+    }
+}
+
+
+namespace
+{
+    constexpr parser::option staticOptions[] = {
+        { "--size", true, "Size of the given vector" },
+        { "--mass", true, "Mass of that thing used by that other thing" },
+        { "--debug", false, "for debug messages" },
+        { "-v" },
+        { "--output", true }
+    };
+
+    constexpr auto staticSchema = parser::makeSchema(staticOptions);
+
+    // The lookup is resolved at compile time
+    static_assert(staticSchema.find("--size") == 0, "--size not found");
+    static_assert(staticSchema.find("-v") == 3, "-v not found");
+    static_assert(staticSchema.find("--sizes") == -1, "unexpected match");
+    static_assert(staticSchema.find("") == -1, "unexpected match");
+}
+
+
+TEST_CASE("Testing compile-time schema")
+{
+
+    SECTION("Every declared name is found"){
+        for(std::size_t i = 0; i < staticSchema.size(); i++)
+            REQUIRE(staticSchema.find(staticOptions[i].name) == int(i));
+    }
+
+    SECTION("Arguments parsed by name and index"){
+
+        int argc = 5;
+
+        char *argv[] = {
+            "program",
+            "--debug",
+            "--size",
+            "2",
+            "-v"
+        };
+
+        constexpr int SIZE = staticSchema.find("--size");
+
+        auto result = staticSchema.parse(argc, argv);
+
+        REQUIRE(result.isDefined("--debug"));
+        REQUIRE(result.isDefined("-v"));
+        REQUIRE(!result.isDefined("--mass"));
+        REQUIRE(!result.isDefined("--unknown"));
+
+        REQUIRE(result.isDefined(SIZE));
+        REQUIRE(result.hasValue(SIZE));
+        REQUIRE(!result.hasValue("--debug"));
+        REQUIRE(result.getArgument<int>(SIZE) == 2);
+        REQUIRE(result.getArgumentView("--size").data() == argv[3]);
+    }
+
+    SECTION("Unexpected argument"){
+
+        int argc = 2;
+
+        char *argv[] = {
+            "program",
+            "--debun"
+        };
+
+        REQUIRE_THROWS_AS(staticSchema.parse(argc, argv), parser::parsing_exception);
+    }
+
+    SECTION("Usage is sorted like ArgumentParser"){
+
+        int argc = 1;
+
+        char *argv[] = {
+            "program"
+        };
+
+        parser::ArgumentParser argParser(argc, argv);
+        for(auto&& option : staticOptions)
+            argParser.addArgument(
+                std::string(option.name),
+                option.hasValue,
+                std::string(option.description));
+
+        REQUIRE(staticSchema.usage("program") == argParser.usage());
+    }
+}
+
+
+TEST_CASE("Testing frozen arguments")
+{
+
+    SECTION("Many arguments are found after freeze"){
+
+        int argc = 6;
+
+        char *argv[] = {
+            "program",
+            "--option-0",
+            "--option-499",
+            "7",
+            "--option-997",
+            "13"
+        };
+
+        parser::ArgumentParser argParser(argc, argv);
+
+        for(int i = 0; i < 1000; i++)
+            argParser.addArgument("--option-" + std::to_string(i), i % 2 == 1);
+
+        REQUIRE(!argParser.isFrozen());
+        argParser.freeze();
+        REQUIRE(argParser.isFrozen());
+
+        argParser.parse();
+
+        REQUIRE(argParser.isDefined("--option-0"));
+        REQUIRE(!argParser.hasValue("--option-0"));
+        REQUIRE(argParser.getArgument<int>("--option-499") == 7);
+        REQUIRE(argParser.getArgument<int>("--option-997") == 13);
+        REQUIRE(!argParser.isDefined("--option-998"));
+        REQUIRE(!argParser.isDefined("--option-1"));
+        REQUIRE(!argParser.isDefined("--option-1000"));
+    }
+
+    SECTION("No argument is added after parse"){
+
+        int argc = 1;
+
+        char *argv[] = {
+            "program"
+        };
+
+        parser::ArgumentParser argParser(argc, argv);
+        argParser.addArgument("--debug");
+
+        REQUIRE(!argParser.isDefined("--debug"));
+
+        argParser.parse();
+
+        REQUIRE(argParser.isFrozen());
+        REQUIRE_THROWS_AS(argParser.addArgument("--late"), std::logic_error);
+    }
+}
+
+
+TEST_CASE("Testing parsing exception details")
+{
+
+    int argc = 4;
+
+    char *argv[] = {
+        "program",
+        "--debug",
+        "--debun",
+        "--size"
+    };
+
+    parser::ArgumentParser argParser(argc, argv);
+    argParser.addArgument("--debug", false, "for debug messages");
+    argParser.addArgument("--size", true, "Size of the given vector");
+
+    try
+    {
+        argParser.parse();
+        FAIL("parsing_exception not thrown");
+    }
+    catch(parser::parsing_exception& e)
+    {
+        REQUIRE(e.token() == "--debun");
+        REQUIRE(e.token().data() == argv[2]);
+        REQUIRE(e.index() == 2);
+        REQUIRE(std::string(e.what()) == "Argument '--debun' not expected.\n");
+        REQUIRE(e.usage() == argParser.usage());
+        REQUIRE(e.message() == std::string(e.what()) + "\n" + argParser.usage());
+    }
+
+    try
+    {
+        staticSchema.parse(argc, argv);
+        FAIL("parsing_exception not thrown");
+    }
+    catch(parser::parsing_exception& e)
+    {
+        REQUIRE(e.index() == 2);
+        REQUIRE(e.usage() == staticSchema.usage("program"));
+    }
+
+    SECTION("The exception outlives the parser"){
+
+        std::string expectedUsage;
+        auto throwing = [&]
+        {
+            parser::ArgumentParser local(argc, argv);
+            local.addArgument("--debug");
+            expectedUsage = local.usage();
+            local.parse();
+        };
+
+        try
+        {
+            throwing();
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(std::string(e.what()) == "Argument '--debun' not expected.\n");
+            REQUIRE(e.usage() == expectedUsage);
+        }
+
+        auto throwingStatic = [&]
+        {
+            parser::StaticArgumentParser<2> local(argc, argv);
+            local.addArgument("--debug");
+            expectedUsage = local.usage();
+            local.parse();
+        };
+
+        try
+        {
+            throwingStatic();
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.usage() == expectedUsage);
+            REQUIRE(e.message() == e.what() + std::string("\n") + expectedUsage);
+        }
+    }
+
+    SECTION("Long tokens are shortened"){
+
+        std::string longToken = "--" + std::string(1000, 'x');
+        char *longArgv[] = { "program", const_cast<char*>(longToken.c_str()) };
+        parser::ArgumentParser local(2, longArgv);
+
+        try
+        {
+            local.parse();
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            std::string message = e.what();
+            REQUIRE(message.size() < 256);
+            REQUIRE(message.find("xxx...' not expected.\n") != std::string::npos);
+            REQUIRE(e.token() == longToken);
+        }
+    }
+}
+
+
+TEST_CASE("Testing response files")
+{
+
+    const char* path = "test_arg_parser.rsp";
+
+    int argc = 4;
+
+    char *argv[] = {
+        "program",
+        "--debug",
+        "@test_arg_parser.rsp",
+        "12"
+    };
+
+    parser::ArgumentParser argParser(argc, argv);
+    argParser.addArgument("--debug");
+    argParser.addArgument("--size", true);
+    argParser.addArgument("--name", true);
+    argParser.addArgument("--path", true);
+    argParser.addArgument("--empty", true);
+    argParser.enableResponseFiles();
+
+    SECTION("Tokens are split with quotes and escapes"){
+
+        {
+            std::ofstream file(path);
+            file << "--name \"John \\\"J\\\" Smith\"\n"
+                 << "  --path 'C:\\dir with spaces'\t--empty ''\n"
+                 << "--size";
+        }
+
+        argParser.parse();
+
+        std::remove(path);
+
+        // The mapping is kept alive by the parser
+        REQUIRE(argParser.isDefined("--debug"));
+        REQUIRE(argParser.getArgumentView("--name") == "John \"J\" Smith");
+        REQUIRE(argParser.getArgumentView("--path") == "C:\\dir with spaces");
+        REQUIRE(argParser.isDefined("--empty"));
+        REQUIRE(argParser.getArgumentView("--empty").empty());
+
+        // The last token of the file takes its value from argv
+        REQUIRE(argParser.getArgument<int>("--size") == 12);
+    }
+
+    SECTION("Missing response file"){
+
+        std::remove(path);
+
+        try
+        {
+            argParser.parse();
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::unreadable_response_file);
+            REQUIRE(e.index() == 2);
+        }
+    }
+
+    SECTION("Unterminated quote"){
+
+        {
+            std::ofstream file(path);
+            file << "--size 5 --name \"John Smith";
+        }
+
+        try
+        {
+            argParser.parse();
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::malformed_response_file);
+        }
+
+        // None of the tokens before the quote are applied
+        parser::Schema schema("program");
+        schema.addArgument("--size", true);
+        schema.addArgument("--name", true);
+        schema.enableResponseFiles();
+        schema.freeze();
+        parser::ParseResult result;
+        char *onlyFile[] = { "program", "@test_arg_parser.rsp" };
+        REQUIRE(schema.tryParse(2, onlyFile, result).code == parser::parse_errc::malformed_response_file);
+        REQUIRE(!result.isDefined("--size"));
+        REQUIRE(!result.isDefined("--name"));
+
+        std::remove(path);
+    }
+
+#if SIMPLE_ARG_PARSER_POSIX
+    SECTION("Pipes are read to the end"){
+
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        const char contents[] = "--name piped --size 7";
+        REQUIRE(write(fds[1], contents, sizeof(contents) - 1) == sizeof(contents) - 1);
+        close(fds[1]);
+
+        // Pipes report no size, so they can't be mapped
+        std::string pipePath = "@/dev/fd/" + std::to_string(fds[0]);
+        char *pipeArgv[] = { "program", &pipePath[0] };
+        parser::ArgumentParser piped(2, pipeArgv);
+        piped.addArgument("--size", true);
+        piped.addArgument("--name", true);
+        piped.enableResponseFiles();
+        piped.parse();
+        close(fds[0]);
+
+        REQUIRE(piped.getArgumentView("--name") == "piped");
+        REQUIRE(piped.getArgument<int>("--size") == 7);
+    }
+#endif
+
+    SECTION("Disabled expansion"){
+
+        argParser.enableResponseFiles(false);
+
+        try
+        {
+            argParser.parse();
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::unexpected_argument);
+            REQUIRE(e.token() == "@test_arg_parser.rsp");
+        }
+    }
+}
+
+
+TEST_CASE("Testing argument handles")
+{
+
+    int argc = 4;
+
+    char *argv[] = {
+        "program",
+        "--trace",
+        "--limit",
+        "25"
+    };
+
+    parser::ArgumentParser argParser(argc, argv);
+
+    auto limit = argParser.addArgument("--limit", true, "Maximum number of items");
+    auto trace = argParser.addArgument("--trace", false, "Trace the requests");
+    auto quiet = argParser.addArgument("--quiet");
+
+    // Handles follow the registration order, not the names
+    REQUIRE(limit.index == 0);
+    REQUIRE(trace.index == 1);
+    REQUIRE(quiet.index == 2);
+
+    // Registering again keeps the handle
+    REQUIRE(argParser.addArgument("--trace", false, "Trace everything").index == trace.index);
+
+    REQUIRE(!argParser.isDefined(trace));
+
+    argParser.parse();
+
+    REQUIRE(argParser.isDefined(trace));
+    REQUIRE(!argParser.hasValue(trace));
+    REQUIRE(argParser.isDefined(limit));
+    REQUIRE(argParser.hasValue(limit));
+    REQUIRE(!argParser.isDefined(quiet));
+    REQUIRE(argParser.getArgument<int>(limit) == 25);
+    REQUIRE(argParser.getArgumentView(limit).data() == argv[3]);
+    REQUIRE_THROWS_AS(argParser.getArgument<int>(quiet), parser::conversion_exception);
+
+    // The names still work
+    REQUIRE(argParser.getArgument<int>("--limit") == 25);
+}
+
+
+TEST_CASE("Testing schema shared between threads")
+{
+
+    parser::Schema schema("program");
+    auto size = schema.addArgument("--size", true, "Size of the given vector");
+    auto debug = schema.addArgument("--debug", false, "for debug messages");
+
+    SECTION("Schema must be frozen"){
+
+        char *argv[] = {
+            "program"
+        };
+
+        REQUIRE_THROWS_AS(schema.parse(1, argv), std::logic_error);
+    }
+
+    schema.freeze();
+
+    SECTION("Independent results"){
+
+        char *argv1[] = {
+            "program",
+            "--size",
+            "1"
+        };
+
+        char *argv2[] = {
+            "program",
+            "--debug"
+        };
+
+        parser::ParseResult first = schema.parse(3, argv1);
+        parser::ParseResult second = schema.parse(2, argv2);
+
+        REQUIRE(first.getArgument<int>(size) == 1);
+        REQUIRE(!first.isDefined(debug));
+        REQUIRE(!second.isDefined("--size"));
+        REQUIRE(second.isDefined("--debug"));
+    }
+
+    SECTION("Concurrent parsing"){
+
+        const int threads = 8;
+        const int parses = 2000;
+
+        std::vector<std::string> values;
+        for(int i = 0; i < threads; i++)
+            values.push_back(std::to_string(i * 100));
+
+        std::vector<int> failures(threads, 0);
+        std::vector<std::thread> workers;
+        for(int t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t]()
+            {
+                char *argv[] = {
+                    "program",
+                    "--size",
+                    &values[t][0],
+                    "--debug"
+                };
+
+                for(int i = 0; i < parses; i++)
+                {
+                    auto result = schema.parse(t % 2 == 0 ? 4 : 3, argv);
+                    if(result.getArgument<int>(size) != t * 100
+                       || result.isDefined(debug) != (t % 2 == 0))
+                        failures[t]++;
+                }
+            });
+        }
+
+        for(auto&& worker : workers)
+            worker.join();
+
+        for(int t = 0; t < threads; t++)
+            REQUIRE(failures[t] == 0);
+    }
+
+    SECTION("Errors refer to the schema"){
+
+        char *argv[] = {
+            "program",
+            "--unknown"
+        };
+
+        try
+        {
+            schema.parse(2, argv);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.usage() == schema.usage());
+        }
+    }
+}
+
+
+TEST_CASE("Testing parser copies")
+{
+
+    int argc = 3;
+
+    char *argv[] = {
+        "program",
+        "--size",
+        "2"
+    };
+
+    parser::ArgumentParser original(argc, argv);
+    original.addArgument("--size", true);
+    original.parse();
+
+    parser::ArgumentParser copy(original);
+    {
+        parser::ArgumentParser temporary(original);
+        copy = temporary;
+    }
+
+    REQUIRE(copy.result().schema() == &copy.schema());
+    REQUIRE(copy.getArgument<int>("--size") == 2);
+    REQUIRE(copy.schema().findArgument("--size") == 0);
+}
+
+
+TEST_CASE("Testing reusable parser")
+{
+
+    parser::ArgumentParser argParser("program");
+    auto size = argParser.addArgument("--size", true, "Size of the given vector");
+    auto debug = argParser.addArgument("--debug", false, "for debug messages");
+
+    char *argv1[] = {
+        "program",
+        "--size",
+        "1",
+        "--debug"
+    };
+
+    char *argv2[] = {
+        "program",
+        "--size",
+        "2"
+    };
+
+    argParser.parse(4, argv1);
+
+    REQUIRE(argParser.getArgument<int>(size) == 1);
+    REQUIRE(argParser.isDefined(debug));
+
+    // The results of the previous input are forgotten
+    argParser.parse(3, argv2);
+
+    REQUIRE(argParser.getArgument<int>(size) == 2);
+    REQUIRE(!argParser.isDefined(debug));
+
+    SECTION("Handles of arguments not given are named in the error"){
+        try
+        {
+            argParser.getArgument<int>(debug);
+            FAIL("conversion_exception not thrown");
+        }
+        catch(parser::conversion_exception& e)
+        {
+            REQUIRE(std::string(e.what()) == "Argument '--debug' not defined.");
+        }
+
+        parser::StaticArgumentParser<2> staticParser(3, argv2);
+        staticParser.addArgument("--size", true);
+        auto staticDebug = staticParser.addArgument("--debug");
+        staticParser.parse();
+        try
+        {
+            staticParser.getArgument<int>(staticDebug);
+            FAIL("conversion_exception not thrown");
+        }
+        catch(parser::conversion_exception& e)
+        {
+            REQUIRE(std::string(e.what()) == "Argument '--debug' not defined.");
+        }
+    }
+
+    SECTION("Reusing a result with a schema"){
+
+        parser::ParseResult result = argParser.schema().parse(4, argv1);
+        result.clear();
+
+        REQUIRE(!result.isDefined(size));
+
+        argParser.schema().parse(3, argv2, result);
+
+        REQUIRE(result.getArgument<int>(size) == 2);
+        REQUIRE(!result.isDefined(debug));
+    }
+}
+
+
+TEST_CASE("Testing batch parsing")
+{
+
+    parser::Schema schema("program");
+    auto size = schema.addArgument("--size", true, "Size of the given vector");
+    auto debug = schema.addArgument("--debug", false, "for debug messages");
+    schema.freeze();
+
+    char *valid[] = {
+        "program",
+        "--size",
+        "3",
+        "--debug"
+    };
+
+    char *invalid[] = {
+        "program",
+        "--size",
+        "3",
+        "--debun"
+    };
+
+    // Enough lines to be split among the threads
+    std::vector<parser::command_line> lines;
+    for(int i = 0; i < 1000; i++)
+        lines.push_back({ 4, i % 3 == 0 ? invalid : valid });
+
+    for(unsigned threads : { 1u, 4u, 0u })
+    {
+        auto entries = schema.parseBatch(lines, threads);
+
+        REQUIRE(entries.size() == lines.size());
+
+        int failures = 0;
+        for(std::size_t i = 0; i < entries.size(); i++)
+        {
+            auto&& entry = entries[i];
+            if(i % 3 == 0)
+            {
+                if(entry.status
+                   || entry.status.code != parser::parse_errc::unexpected_argument
+                   || entry.status.index != 3
+                   || entry.status.token != "--debun")
+                    failures++;
+            }
+            else
+            {
+                if(!entry.status
+                   || entry.result.getArgument<int>(size) != 3
+                   || !entry.result.isDefined(debug))
+                    failures++;
+            }
+        }
+
+        REQUIRE(failures == 0);
+    }
+}
+
+
+TEST_CASE("Testing bound variables")
+{
+
+    int size = 10;
+    double mass = 0;
+    std::string name = "nobody";
+    bool debug = false;
+    bool quiet = false;
+
+    parser::ArgumentParser argParser("program");
+    argParser.addArgument("--size", &size, "Size of the given vector");
+    argParser.addArgument("--mass", &mass, "Mass of that thing");
+    argParser.addArgument("--name", &name, "Name of the user");
+    argParser.addArgument("--debug", &debug, "for debug messages");
+    argParser.addArgument("--quiet", &quiet, "no messages at all");
+
+    SECTION("Values are stored after parsing"){
+
+        char *argv[] = {
+            "program",
+            "--mass",
+            "35.5",
+            "--debug",
+            "--name",
+            "John Smith"
+        };
+
+        argParser.parse(6, argv);
+
+        REQUIRE(mass == 35.5);
+        REQUIRE(debug);
+        REQUIRE(name == "John Smith");
+
+        // Arguments not given keep their defaults
+        REQUIRE(size == 10);
+        REQUIRE(!quiet);
+
+        // The usual accessors still work
+        REQUIRE(argParser.hasValue("--mass"));
+        REQUIRE(!argParser.hasValue("--debug"));
+        REQUIRE(argParser.getArgumentView("--name") == "John Smith");
+    }
+
+    SECTION("Invalid values are parsing errors"){
+
+        char *argv[] = {
+            "program",
+            "--size",
+            "ten"
+        };
+
+        try
+        {
+            argParser.parse(3, argv);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::invalid_value);
+            REQUIRE(e.index() == 2);
+            REQUIRE(e.token() == "ten");
+        }
+
+        REQUIRE(size == 10);
+    }
+
+    SECTION("A failed parse stores nothing"){
+
+        char *argv[] = {
+            "program",
+            "--mass",
+            "35.5",
+            "--debug",
+            "--size",
+            "ten"
+        };
+
+        REQUIRE(argParser.tryParse(6, argv).code == parser::parse_errc::invalid_value);
+        REQUIRE(mass == 0);
+        REQUIRE(!debug);
+
+        // The schema alone never writes to the variables
+        parser::ParseResult result;
+        REQUIRE(argParser.schema().tryParse(3, argv, result));
+        REQUIRE(mass == 0);
+        result.store();
+        REQUIRE(mass == 35.5);
+    }
+}
+
+
+namespace
+{
+    struct Config
+    {
+        int size = 10;
+        double mass = 0;
+        std::string name = "nobody";
+        bool debug = false;
+    };
+
+    constexpr auto configSchema = parser::makeSchema(
+        parser::field("--size", &Config::size, "Size of the given vector"),
+        parser::field("--mass", &Config::mass, "Mass of that thing"),
+        parser::field("--name", &Config::name, "Name of the user"),
+        parser::field("--debug", &Config::debug, "for debug messages"));
+
+    static_assert(configSchema.find("--name") == 2, "--name not found");
+    static_assert(configSchema.find("--names") == -1, "unexpected match");
+}
+
+
+TEST_CASE("Testing struct binding")
+{
+
+    SECTION("The struct is filled in one pass"){
+
+        char *argv[] = {
+            "program",
+            "--debug",
+            "--mass",
+            "35.5",
+            "--name",
+            "John Smith"
+        };
+
+        Config config = configSchema.parse(6, argv);
+
+        REQUIRE(config.debug);
+        REQUIRE(config.mass == 35.5);
+        REQUIRE(config.name == "John Smith");
+        REQUIRE(config.size == 10);
+    }
+
+    SECTION("Same usage as the other parsers"){
+
+        parser::ArgumentParser argParser("program");
+        argParser.addArgument("--size", true, "Size of the given vector");
+        argParser.addArgument("--mass", true, "Mass of that thing");
+        argParser.addArgument("--name", true, "Name of the user");
+        argParser.addArgument("--debug", false, "for debug messages");
+
+        REQUIRE(configSchema.usage("program") == argParser.usage());
+    }
+
+    SECTION("Errors are reported as parsing exceptions"){
+
+        char *unexpected[] = { "program", "--size", "3", "--sizes" };
+        char *invalid[] = { "program", "--size", "3x" };
+
+        Config config;
+        try
+        {
+            configSchema.parse(4, unexpected, config);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::unexpected_argument);
+            REQUIRE(e.index() == 3);
+        }
+        REQUIRE(config.size == 3);
+
+        try
+        {
+            configSchema.parse(3, invalid);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::invalid_value);
+            REQUIRE(e.token() == "3x");
+        }
+    }
+}
+
+
+TEST_CASE("Testing heap-free parser")
+{
+
+    char *argv[] = {
+        "program",
+        "--mass",
+        "35.5",
+        "--debug",
+        "--name",
+        "John Smith"
+    };
+
+    parser::StaticArgumentParser<8> argParser(6, argv);
+    auto size = argParser.addArgument("--size", true, "Size of the given vector");
+    auto mass = argParser.addArgument("--mass", true, "Mass of that thing");
+    auto debug = argParser.addArgument("--debug", false, "for debug messages");
+    argParser.addArgument("--name", true, "Name of the user");
+    argParser.parse();
+
+    REQUIRE(argParser.isDefined(debug));
+    REQUIRE(!argParser.hasValue(debug));
+    REQUIRE(!argParser.isDefined(size));
+    REQUIRE(argParser.hasValue(mass));
+    REQUIRE(argParser.getArgumentView("--name") == "John Smith");
+    REQUIRE(argParser.getArgument<double>(mass) == 35.5);
+
+    SECTION("Same behavior as ArgumentParser"){
+
+        parser::ArgumentParser reference(6, argv);
+        reference.addArgument("--size", true, "Size of the given vector");
+        reference.addArgument("--mass", true, "Mass of that thing");
+        reference.addArgument("--debug", false, "for debug messages");
+        reference.addArgument("--name", true, "Name of the user");
+
+        REQUIRE(argParser.usage() == reference.usage());
+        REQUIRE(argParser.addArgument("--mass", true).index == mass.index);
+    }
+
+    SECTION("Capacity is checked"){
+
+        parser::StaticArgumentParser<2> small("program");
+        small.addArgument("-a");
+        small.addArgument("-b");
+        REQUIRE_THROWS_AS(small.addArgument("-c"), std::length_error);
+    }
+
+    SECTION("Unexpected arguments"){
+
+        char *wrong[] = { "program", "--debug", "--sizes" };
+
+        try
+        {
+            argParser.parse(3, wrong);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.index() == 2);
+            REQUIRE(e.token() == "--sizes");
+        }
+    }
+}
+
+
+TEST_CASE("Testing parse without exceptions")
+{
+
+    char *argv[] = {
+        "program",
+        "--size",
+        "12",
+        "--wrong",
+        "--debug"
+    };
+
+    SECTION("Errors are returned"){
+
+        parser::ArgumentParser argParser(5, argv);
+        argParser.addArgument("--size", true, "Size of the given vector");
+        argParser.addArgument("--debug", false, "for debug messages");
+
+        parser::parse_status status = argParser.tryParse();
+
+        REQUIRE(!status);
+        REQUIRE(status.code == parser::parse_errc::unexpected_argument);
+        REQUIRE(status.index == 3);
+        REQUIRE(status.token == "--wrong");
+
+        // Arguments found before the error are kept
+        REQUIRE(argParser.getArgument<int>("--size") == 12);
+        REQUIRE(!argParser.isDefined("--debug"));
+
+        REQUIRE(argParser.tryParse(3, argv));
+        REQUIRE(argParser.getArgument<int>("--size") == 12);
+    }
+
+    SECTION("Same status from every parser"){
+
+        parser::Schema schema("program");
+        schema.addArgument("--size", true);
+        schema.addArgument("--debug");
+        schema.freeze();
+        parser::ParseResult result;
+
+        parser::StaticArgumentParser<4> staticParser("program");
+        staticParser.addArgument("--size", true);
+        staticParser.addArgument("--debug");
+
+        auto schemaStatus = schema.tryParse(5, argv, result);
+        auto staticStatus = staticParser.tryParse(5, argv);
+
+        REQUIRE(schemaStatus.index == 3);
+        REQUIRE(staticStatus.index == 3);
+        REQUIRE(staticStatus.token == schemaStatus.token);
+
+        parser::StaticParseResult<5> staticResult(staticSchema);
+        auto compiledStatus = staticSchema.tryParse(5, argv, staticResult);
+        REQUIRE(compiledStatus.code == parser::parse_errc::unexpected_argument);
+        REQUIRE(compiledStatus.index == 3);
+        REQUIRE(staticResult.getArgumentView("--size") == "12");
+
+        Config config;
+        auto structStatus = configSchema.tryParse(5, argv, config);
+        REQUIRE(structStatus.index == 3);
+        REQUIRE(config.size == 12);
+    }
+
+    SECTION("Every parser reports a missing value"){
+
+        char *truncated[] = { "program", "--debug", "--size" };
+
+        parser::Schema schema("program");
+        schema.addArgument("--size", true);
+        schema.addArgument("--debug");
+        schema.freeze();
+        parser::ParseResult result;
+        auto schemaStatus = schema.tryParse(3, truncated, result);
+        REQUIRE(schemaStatus.code == parser::parse_errc::missing_value);
+        REQUIRE(schemaStatus.index == 2);
+
+        parser::StaticArgumentParser<4> staticParser("program");
+        staticParser.addArgument("--size", true);
+        staticParser.addArgument("--debug");
+        auto staticStatus = staticParser.tryParse(3, truncated);
+        REQUIRE(staticStatus.code == parser::parse_errc::missing_value);
+        REQUIRE(staticStatus.index == 2);
+        REQUIRE(staticStatus.token == "--size");
+
+        parser::StaticParseResult<5> staticResult(staticSchema);
+        auto compiledStatus = staticSchema.tryParse(3, truncated, staticResult);
+        REQUIRE(compiledStatus.code == parser::parse_errc::missing_value);
+        REQUIRE(compiledStatus.index == 2);
+        REQUIRE(!staticResult.isDefined("--size"));
+
+        Config config;
+        auto structStatus = configSchema.tryParse(3, truncated, config);
+        REQUIRE(structStatus.code == parser::parse_errc::missing_value);
+        REQUIRE(structStatus.index == 2);
+        REQUIRE(structStatus.token == "--size");
+
+        REQUIRE_THROWS_AS(configSchema.parse(3, truncated), parser::parsing_exception);
+    }
+}
+
+
+TEST_CASE("Testing shell completion")
+{
+
+    parser::Schema schema("program");
+    schema.addArgument("--size", true, "Size of the given vector");
+    schema.addArgument("--sigma", true);
+    schema.addArgument("--debug");
+    schema.addArgument("-v");
+    schema.freeze();
+
+    SECTION("Names are found by prefix"){
+
+        std::vector<std::string_view> names;
+        schema.completions("--si", [&names](std::string_view name){ names.push_back(name); });
+
+        REQUIRE(names.size() == 2);
+        REQUIRE(names[0] == "--sigma");
+        REQUIRE(names[1] == "--size");
+
+        names.clear();
+        schema.completions("--x", [&names](std::string_view name){ names.push_back(name); });
+        REQUIRE(names.empty());
+    }
+
+    SECTION("Completion requests are answered"){
+
+        char *partial[] = { "program", "__complete", "2", "program", "--debug", "--s" };
+        char *empty[] = { "program", "__complete", "1", "program" };
+        char *value[] = { "program", "__complete", "2", "program", "--size", "" };
+        char *normal[] = { "program", "--debug" };
+
+        std::ostringstream out;
+        REQUIRE(schema.handleCompletion(6, partial, out));
+        REQUIRE(out.str() == "--sigma\n--size\n");
+
+        out.str("");
+        REQUIRE(schema.handleCompletion(4, empty, out));
+        REQUIRE(out.str() == "--debug\n--sigma\n--size\n-v\n");
+
+        // Values are left for the shell
+        out.str("");
+        REQUIRE(schema.handleCompletion(6, value, out));
+        REQUIRE(out.str().empty());
+
+        REQUIRE(!schema.handleCompletion(2, normal, out));
+
+        out.str("");
+        REQUIRE(staticSchema.handleCompletion(6, partial, out));
+        REQUIRE(out.str() == "--size\n");
+    }
+
+    SECTION("Scripts ask the program"){
+
+        std::ostringstream bash;
+        schema.writeCompletionScript(bash, parser::completion_shell::bash, "/usr/bin/my-program");
+        REQUIRE(bash.str().find("\"$1\" __complete \"$COMP_CWORD\" \"${COMP_WORDS[@]}\"") != std::string::npos);
+        REQUIRE(bash.str().find("--size") == std::string::npos);
+        REQUIRE(bash.str().find("complete -o default -F _my_program_complete 'my-program'") != std::string::npos);
+
+        std::ostringstream zsh;
+        schema.writeCompletionScript(zsh, parser::completion_shell::zsh);
+        REQUIRE(zsh.str().find("#compdef 'program'") == 0);
+
+        // Names are quoted for the shell
+        std::ostringstream quoted;
+        schema.writeCompletionScript(quoted, parser::completion_shell::bash, "it's$(x)");
+        REQUIRE(quoted.str().find("_it_s__x__complete 'it'\\''s$(x)'\n") != std::string::npos);
+    }
+
+    SECTION("Subcommands are completed"){
+
+        parser::Schema tool("tool");
+        tool.addArgument("--level", true);
+        tool.addSubcommand("commit", [](parser::Schema& commit)
+        {
+            commit.addArgument("--message", true);
+            commit.addArgument("--amend");
+        });
+        tool.addSubcommand("clone", [](parser::Schema&) { });
+        tool.freeze();
+
+        char *first[] = { "tool", "__complete", "3", "tool", "--level", "2", "c" };
+        char *inside[] = { "tool", "__complete", "2", "tool", "commit", "--" };
+        char *value[] = { "tool", "__complete", "3", "tool", "commit", "--message", "" };
+
+        std::ostringstream out;
+        REQUIRE(tool.handleCompletion(7, first, out));
+        REQUIRE(out.str() == "commit\nclone\n");
+
+        out.str("");
+        REQUIRE(tool.handleCompletion(6, inside, out));
+        REQUIRE(out.str() == "--amend\n--message\n");
+
+        out.str("");
+        REQUIRE(tool.handleCompletion(7, value, out));
+        REQUIRE(out.str().empty());
+    }
+}
+
+
+TEST_CASE("Testing streamed usage")
+{
+
+    parser::ArgumentParser argParser("program");
+    argParser.addArgument("--size", true, "Size of the given vector, which must be a positive number small enough to fit in memory");
+    argParser.addArgument("--mass", true, "Mass of that thing used by that other thing");
+    argParser.addArgument("--debug", false, "for debug messages");
+    argParser.addArgument("-v");
+    argParser.freeze();
+
+    SECTION("Without wrapping it's the same text as usage()"){
+
+        std::ostringstream stream;
+        std::string text;
+
+        std::size_t length = argParser.writeUsage(stream, 0);
+        argParser.writeUsage(text, 0);
+
+        REQUIRE(stream.str() == argParser.usage());
+        REQUIRE(text == argParser.usage());
+        REQUIRE(length == text.size());
+        REQUIRE(staticSchema.writeUsage(text = "", "program", 0) == staticSchema.usage("program").size());
+        REQUIRE(text == staticSchema.usage("program"));
+    }
+
+    SECTION("Lines are wrapped to the width"){
+
+        std::string text;
+        argParser.writeUsage(text, 40);
+
+        std::istringstream lines(text);
+        std::string line;
+        std::size_t count = 0;
+        while(std::getline(lines, line))
+        {
+            REQUIRE(line.size() <= 40);
+            count++;
+        }
+        REQUIRE(count > 12);
+        REQUIRE(text.find("\n            [ --size val]  [ -v ]\n") != std::string::npos);
+        REQUIRE(text.find("positive\n        number") != std::string::npos);
+    }
+
+    SECTION("Buffers are never overflowed"){
+
+        char buffer[32];
+        buffer[31] = 'x';
+        std::size_t length = argParser.writeUsage({ buffer, 31 }, 0);
+
+        REQUIRE(length == argParser.usage().size());
+        REQUIRE(std::string(buffer) == argParser.usage().substr(0, 30));
+        REQUIRE(buffer[31] == 'x');
+    }
+
+    SECTION("Files and descriptors"){
+
+        std::FILE* file = std::tmpfile();
+        argParser.writeUsage(file, 0);
+        argParser.writeUsage(parser::output_sink::descriptor(fileno(file)), 0);
+
+        std::string usage = argParser.usage();
+        std::string text(2 * usage.size(), '\0');
+        std::rewind(file);
+        REQUIRE(std::fread(&text[0], 1, text.size(), file) == text.size());
+        std::fclose(file);
+
+        REQUIRE(text == usage + usage);
+    }
+
+    SECTION("Sinks that aren't terminals take 80 columns"){
+
+#if SIMPLE_ARG_PARSER_POSIX
+        setenv("COLUMNS", "30", 1);
+#endif
+        std::string expected;
+        argParser.writeUsage(expected, 80);
+
+        std::string text;
+        argParser.writeUsage(text);
+        REQUIRE(text == expected);
+
+        char buffer[1024];
+        argParser.writeUsage({ buffer, sizeof(buffer) });
+        REQUIRE(buffer == expected);
+
+        std::FILE* file = std::tmpfile();
+        argParser.writeUsage(file);
+        std::rewind(file);
+        text.assign(expected.size(), '\0');
+        REQUIRE(std::fread(&text[0], 1, text.size(), file) == text.size());
+        std::fclose(file);
+        REQUIRE(text == expected);
+
+        REQUIRE(staticSchema.writeUsage(text = "", "program") == staticSchema.writeUsage(expected = "", "program", 80));
+        REQUIRE(text == expected);
+#if SIMPLE_ARG_PARSER_POSIX
+        unsetenv("COLUMNS");
+#endif
+    }
+}
+
+
+TEST_CASE("Testing name pre-filter")
+{
+
+    parser::Schema schema("program");
+    schema.addArgument("-v");
+    schema.addArgument("--size", true);
+    schema.addArgument("+x");
+    schema.freeze();
+
+    parser::StaticArgumentParser<4> staticParser("program");
+    staticParser.addArgument("-v");
+    staticParser.addArgument("--size", true);
+    staticParser.addArgument("+x");
+
+    SECTION("Registered names pass"){
+
+        for(auto name : { "-v", "--size", "+x" })
+        {
+            REQUIRE(schema.findArgument(name) >= 0);
+            REQUIRE(staticParser.findArgument(name) >= 0);
+        }
+        static_assert(staticSchema.find("--output") == 4, "--output not found");
+    }
+
+    SECTION("Values and unknown names are rejected"){
+
+        for(auto token : { "", "v", "/usr/lib/libc.so", "--sizes", "-x", "+v", "x+", "--siz" })
+        {
+            REQUIRE(schema.findArgument(token) == -1);
+            REQUIRE(staticParser.findArgument(token) == -1);
+            REQUIRE(staticSchema.find(token) == -1);
+        }
+    }
+}
+
+
+TEST_CASE("Testing constraints")
+{
+
+    parser::Schema schema("program");
+    auto input = schema.addArgument("--input", true, "Input file");
+    auto output = schema.addArgument("--output", true, "Output file");
+    auto format = schema.addArgument("--format", true, "Output format");
+    auto quiet = schema.addArgument("--quiet");
+    auto verbose = schema.addArgument("--verbose");
+    auto json = schema.addArgument("--json");
+    auto xml = schema.addArgument("--xml");
+
+    // Enough arguments to spread the masks over many words
+    for(int i = 0; i < 150; i++)
+        schema.addArgument("--option-" + std::to_string(i));
+    auto last = schema.addArgument("--last");
+
+    schema.addRequired(input);
+    schema.addExclusive({ quiet, verbose, last });
+    schema.addDependency(format, output);
+    schema.addAtLeastOne({ json, xml, last });
+    schema.freeze();
+
+    auto check = [&schema](std::vector<const char*> tokens)
+    {
+        std::vector<char*> argv = { const_cast<char*>("program") };
+        for(auto token : tokens)
+            argv.push_back(const_cast<char*>(token));
+        parser::ParseResult result;
+        return schema.tryParse(static_cast<int>(argv.size()), argv.data(), result);
+    };
+
+    SECTION("Valid inputs"){
+        REQUIRE(check({ "--input", "a", "--json" }));
+        REQUIRE(check({ "--input", "a", "--xml", "--quiet", "--format", "csv", "--output", "b" }));
+        REQUIRE(check({ "--last", "--input", "a" }));
+    }
+
+    SECTION("Required arguments"){
+        auto status = check({ "--json" });
+        REQUIRE(status.code == parser::parse_errc::missing_argument);
+        REQUIRE(status.index == -1);
+        REQUIRE(status.token == "--input");
+    }
+
+    SECTION("Mutually exclusive arguments"){
+        auto status = check({ "--input", "a", "--json", "--verbose", "--quiet" });
+        REQUIRE(status.code == parser::parse_errc::excluded_argument);
+        REQUIRE(status.token == "--verbose");
+
+        status = check({ "--input", "a", "--last", "--quiet" });
+        REQUIRE(status.code == parser::parse_errc::excluded_argument);
+        REQUIRE(status.token == "--last");
+    }
+
+    SECTION("Dependencies"){
+        auto status = check({ "--input", "a", "--json", "--format", "csv" });
+        REQUIRE(status.code == parser::parse_errc::missing_dependency);
+        REQUIRE(status.token == "--output");
+    }
+
+    SECTION("Alternatives"){
+        auto status = check({ "--input", "a" });
+        REQUIRE(status.code == parser::parse_errc::missing_alternative);
+        REQUIRE(status.token == "--json");
+    }
+
+    SECTION("Reported by parse() too"){
+
+        char *argv[] = { "program", "--json" };
+
+        try
+        {
+            schema.parse(2, argv);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::missing_argument);
+            REQUIRE(std::string(e.what()) == "Argument '--input' is required.\n");
+        }
+    }
+
+    SECTION("Reported names outlive the parser"){
+
+        char *argv[] = { "program", "--debug=yes" };
+        auto throwing = [&argv](int argc)
+        {
+            parser::ArgumentParser local(argc, argv);
+            local.addRequired(local.addArgument("--" + std::string(40, 'r')));
+            local.addArgument("--debug");
+            local.parse();
+        };
+
+        try
+        {
+            throwing(1);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::missing_argument);
+            REQUIRE(e.token() == "--" + std::string(40, 'r'));
+        }
+
+        try
+        {
+            throwing(2);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::unexpected_value);
+            REQUIRE(e.token() == "--debug");
+        }
+    }
+
+    SECTION("Constraints can't change after freeze"){
+        REQUIRE_THROWS_AS(schema.addRequired(output), std::logic_error);
+
+        parser::Schema other;
+        REQUIRE_THROWS_AS(other.addRequired(input), std::logic_error);
+    }
+
+    SECTION("Copies keep the constraints"){
+        parser::Schema copy(schema);
+        parser::ParseResult result;
+        char *argv[] = { "program", "--json" };
+        REQUIRE(copy.tryParse(2, argv, result).code == parser::parse_errc::missing_argument);
+    }
+}
+
+
+TEST_CASE("Testing GNU syntax")
+{
+
+    parser::Schema schema("program");
+    bool color = true;
+    int jobs = 0;
+    auto verbose = schema.addArgument("-v");
+    auto all = schema.addArgument("-a");
+    auto jobsArg = schema.addArgument("-j", &jobs, "Parallel jobs");
+    auto output = schema.addArgument("--output", true, "Output file");
+    auto colorArg = schema.addArgument("--color", &color, "Colored output");
+    auto noCache = schema.addArgument("--no-cache");
+    schema.freeze();
+
+    parser::ParseResult result;
+    auto check = [&schema, &result](std::vector<const char*> tokens)
+    {
+        std::vector<char*> argv = { const_cast<char*>("program") };
+        for(auto token : tokens)
+            argv.push_back(const_cast<char*>(token));
+        result.clear();
+        auto status = schema.tryParse(int(argv.size()), argv.data(), result);
+        if(status)
+            result.store();
+        return status;
+    };
+
+    SECTION("Inline long values"){
+        REQUIRE(check({ "--output=out.txt" }));
+        REQUIRE(result.getArgumentView(output) == "out.txt");
+
+        REQUIRE(check({ "--output=" }));
+        REQUIRE(result.isDefined(output));
+        REQUIRE(result.getArgumentView(output) == "");
+
+        auto status = check({ "--color=yes" });
+        REQUIRE(status.code == parser::parse_errc::unexpected_value);
+        REQUIRE(status.token == "--color");
+    }
+
+    SECTION("Clustered short flags and attached values"){
+        REQUIRE(check({ "-vva", "-j8" }));
+        REQUIRE(result.count(verbose) == 2);
+        REQUIRE(result.count("-a") == 1);
+        REQUIRE(result.getArgumentView(jobsArg) == "8");
+        REQUIRE(jobs == 8);
+
+        REQUIRE(check({ "-vj", "4" }));
+        REQUIRE(result.count(verbose) == 1);
+        REQUIRE_FALSE(result.isDefined(all));
+        REQUIRE(jobs == 4);
+
+        auto status = check({ "-vx" });
+        REQUIRE(status.code == parser::parse_errc::unexpected_argument);
+        REQUIRE(status.token == "-vx");
+    }
+
+    SECTION("Negated flags"){
+        REQUIRE(check({ "--color", "--no-color" }));
+        REQUIRE_FALSE(result.isDefined(colorArg));
+        REQUIRE(result.count(colorArg) == 0);
+        REQUIRE_FALSE(color);
+
+        // An exact name wins over the negated form
+        REQUIRE(check({ "--no-cache" }));
+        REQUIRE(result.isDefined(noCache));
+
+        REQUIRE(check({ "--no-output" }).code == parser::parse_errc::unexpected_argument);
+    }
+
+    SECTION("Operands after the terminator"){
+        REQUIRE(check({ "-v", "--", "-a", "--output" }));
+        REQUIRE(result.isDefined(verbose));
+        REQUIRE_FALSE(result.isDefined(all));
+        REQUIRE(result.operands().size() == 2);
+        REQUIRE(result.operands()[0] == "-a");
+        REQUIRE(result.operands()[1] == "--output");
+
+        REQUIRE(check({ "-v" }));
+        REQUIRE(result.operands().empty());
+    }
+
+    SECTION("Missing values are reported"){
+        auto status = check({ "-v", "--output" });
+        REQUIRE(status.code == parser::parse_errc::missing_value);
+        REQUIRE(status.index == 2);
+        REQUIRE(status.token == "--output");
+
+        REQUIRE(check({ "-j" }).code == parser::parse_errc::missing_value);
+    }
+}
+
+
+TEST_CASE("Testing multiple values")
+{
+
+    parser::Schema schema("program");
+    auto point = schema.addArgument("--point", parser::arity::exactly(3), "Coordinates");
+    auto files = schema.addArgument("--files", parser::arity::oneOrMore(), "Input files");
+    auto tags = schema.addArgument("--tags", parser::arity::any(), "Tags");
+    auto include = schema.addArgument("-I", parser::arity::repeated(), "Include directory");
+    auto defines = schema.addArgument("-D", parser::arity::repeated(parser::arity::oneOrMore()));
+    auto verbose = schema.addArgument("-v");
+    auto output = schema.addArgument("--output", true, "Output file");
+    schema.freeze();
+
+    parser::ParseResult result;
+    auto check = [&schema, &result](std::vector<const char*> tokens)
+    {
+        std::vector<char*> argv = { const_cast<char*>("program") };
+        for(auto token : tokens)
+            argv.push_back(const_cast<char*>(token));
+        result.clear();
+        return schema.tryParse(int(argv.size()), argv.data(), result);
+    };
+    auto list = [](parser::value_range range)
+    {
+        return std::vector<std::string_view>(range.begin(), range.end());
+    };
+    using views = std::vector<std::string_view>;
+
+    SECTION("Fixed number of values"){
+        REQUIRE(check({ "--point", "1", "-2", "3", "-v" }));
+        REQUIRE(list(result.values(point)) == views{ "1", "-2", "3" });
+        REQUIRE(result.isDefined(verbose));
+
+        auto status = check({ "-v", "--point", "1", "2" });
+        REQUIRE(status.code == parser::parse_errc::missing_value);
+        REQUIRE(status.index == 2);
+        REQUIRE(status.token == "--point");
+    }
+
+    SECTION("Variable number of values"){
+        REQUIRE(check({ "--files", "a", "b", "c", "--tags", "-v" }));
+        REQUIRE(list(result.values(files)) == views{ "a", "b", "c" });
+        REQUIRE(result.isDefined(tags));
+        REQUIRE(result.values(tags).empty());
+        REQUIRE(result.isDefined(verbose));
+
+        REQUIRE(check({ "--files", "--odd-name", "b", "--", "c" }));
+        REQUIRE(list(result.values("--files")) == views{ "--odd-name", "b" });
+        REQUIRE(result.operands().size() == 1);
+
+        REQUIRE(check({ "--files=a", "b" }));
+        REQUIRE(list(result.values(files)) == views{ "a", "b" });
+
+        REQUIRE(check({ "--files" }).code == parser::parse_errc::missing_value);
+    }
+
+    SECTION("Repeated arguments"){
+        REQUIRE(check({ "-I", "a", "-Ib", "-v", "-I", "c", "-D", "X", "Y", "-D", "Z" }));
+        REQUIRE(list(result.values(include)) == views{ "a", "b", "c" });
+        REQUIRE(result.count(include) == 3);
+        REQUIRE(list(result.values(defines)) == views{ "X", "Y", "Z" });
+        REQUIRE(result.getArgumentView(include) == "c");
+
+        // Only the last occurrence of the others is kept
+        REQUIRE(check({ "--files", "a", "-I", "x", "--files", "b", "c" }));
+        REQUIRE(list(result.values(files)) == views{ "b", "c" });
+        REQUIRE(list(result.values(include)) == views{ "x" });
+    }
+
+    SECTION("Single values are ranges too"){
+        REQUIRE(check({ "--output", "out.txt" }));
+        REQUIRE(list(result.values(output)) == views{ "out.txt" });
+        REQUIRE(result.values(verbose).empty());
+        REQUIRE(result.values(include).empty());
+        REQUIRE(result.values("--unknown").empty());
+    }
+
+    SECTION("Through ArgumentParser"){
+        char *argv[] = { "program", "-I", "a", "-I", "b" };
+        parser::ArgumentParser argParser(5, argv);
+        auto handle = argParser.addArgument("-I", parser::arity::repeated());
+        argParser.parse();
+        REQUIRE(list(argParser.values(handle)) == views{ "a", "b" });
+    }
+}
+
+
+TEST_CASE("Testing positional arguments")
+{
+
+    parser::Schema schema("tool");
+    auto fast = schema.addArgument("--fast", false, "Go fast");
+    auto level = schema.addArgument("--level", true, "Compression level");
+    auto input = schema.addPositional("input", "Input file");
+    auto output = schema.addPositional("output", parser::arity::optional(), "Output file");
+    auto extras = schema.addPositional("extras", parser::arity::any(), "Extra files");
+    schema.freeze();
+
+    parser::ParseResult result;
+    auto check = [&schema, &result](std::vector<const char*> tokens)
+    {
+        std::vector<char*> argv = { const_cast<char*>("tool") };
+        for(auto token : tokens)
+            argv.push_back(const_cast<char*>(token));
+        result.clear();
+        return schema.tryParse(int(argv.size()), argv.data(), result);
+    };
+    auto list = [](parser::value_range range)
+    {
+        return std::vector<std::string_view>(range.begin(), range.end());
+    };
+    using views = std::vector<std::string_view>;
+
+    SECTION("Interleaved with the named arguments"){
+        REQUIRE(check({ "in.dat", "--fast", "out.dat", "--level", "9", "a", "-", "b" }));
+        REQUIRE(result.isDefined(fast));
+        REQUIRE(result.getArgumentView(level) == "9");
+        REQUIRE(result.getArgumentView(input) == "in.dat");
+        REQUIRE(result.getArgumentView("output") == "out.dat");
+        REQUIRE(list(result.values(extras)) == views{ "a", "-", "b" });
+        REQUIRE(result.count(extras) == 3);
+    }
+
+    SECTION("Optional slots"){
+        REQUIRE(check({ "--fast", "in.dat" }));
+        REQUIRE(result.getArgumentView(input) == "in.dat");
+        REQUIRE_FALSE(result.isDefined(output));
+        REQUIRE(result.values(extras).empty());
+    }
+
+    SECTION("Required slots"){
+        auto status = check({ "--fast" });
+        REQUIRE(status.code == parser::parse_errc::missing_argument);
+        REQUIRE(status.token == "input");
+    }
+
+    SECTION("Tokens after the terminator"){
+        REQUIRE(check({ "--", "--fast", "out.dat" }));
+        REQUIRE_FALSE(result.isDefined(fast));
+        REQUIRE(result.getArgumentView(input) == "--fast");
+        REQUIRE(result.getArgumentView(output) == "out.dat");
+        REQUIRE(result.operands().empty());
+    }
+
+    SECTION("Names aren't matched"){
+        REQUIRE(check({ "input", "output" }));
+        REQUIRE(result.getArgumentView(input) == "input");
+        REQUIRE(result.getArgumentView(output) == "output");
+        REQUIRE(schema.findArgument("input") == -1);
+
+        REQUIRE(check({ "in.dat", "--unknown" }).code == parser::parse_errc::unexpected_argument);
+    }
+
+    SECTION("Extra tokens without a slot"){
+        parser::Schema small("tool");
+        small.addPositional("input");
+        small.freeze();
+
+        char *argv[] = { "tool", "a", "b" };
+        parser::ParseResult smallResult;
+        auto status = small.tryParse(3, argv, smallResult);
+        REQUIRE(status.code == parser::parse_errc::unexpected_argument);
+        REQUIRE(status.index == 2);
+
+        char *terminated[] = { "tool", "--", "a", "b" };
+        smallResult.clear();
+        REQUIRE(small.tryParse(4, terminated, smallResult));
+        REQUIRE(smallResult.operands() == views{ "b" });
+    }
+
+    SECTION("Shown in the usage after the named ones"){
+        std::string usage = schema.usage();
+        REQUIRE(usage.find("[ --level val]") < usage.find("[ input ]"));
+        REQUIRE(usage.find("[ input ]") < usage.find("[ output ]"));
+        REQUIRE(usage.find("[ output ]") < usage.find("[ extras ]"));
+
+        std::ostringstream script;
+        schema.writeCompletionScript(script);
+        REQUIRE(script.str().find("extras") == std::string::npos);
+    }
+
+    SECTION("Through ArgumentParser"){
+        char *argv[] = { "tool", "--fast", "in.dat" };
+        parser::ArgumentParser argParser(3, argv);
+        argParser.addArgument("--fast");
+        auto file = argParser.addPositional("input");
+        argParser.parse();
+        REQUIRE(argParser.getArgumentView(file) == "in.dat");
+    }
+}
+
+
+TEST_CASE("Testing subcommands")
+{
+
+    int built = 0;
+    parser::Schema schema("tool");
+    auto verbose = schema.addArgument("-v");
+    schema.addSubcommand("commit", [&built](parser::Schema& commit)
+    {
+        built++;
+        commit.addArgument("--message", true, "Commit message");
+        commit.addArgument("--all");
+        commit.addPositional("files", parser::arity::any());
+    }, "Record changes");
+    schema.addSubcommand("push", [&built](parser::Schema& push)
+    {
+        built++;
+        push.addPositional("remote");
+    }, "Update remote refs");
+    // Many unused subcommands, never built
+    for(int i = 0; i < 40; i++)
+        schema.addSubcommand("command" + std::to_string(i), [&built](parser::Schema&) { built += 100; });
+    schema.freeze();
+
+    parser::ParseResult result;
+    auto check = [&schema, &result](std::vector<const char*> tokens)
+    {
+        std::vector<char*> argv = { const_cast<char*>("tool") };
+        for(auto token : tokens)
+            argv.push_back(const_cast<char*>(token));
+        result.clear();
+        return schema.tryParse(int(argv.size()), argv.data(), result);
+    };
+
+    SECTION("Only the selected subcommand is built"){
+        REQUIRE(built == 0);
+        REQUIRE(check({ "-v", "commit", "--message", "fix", "-v", "a.txt" }).code
+            == parser::parse_errc::unexpected_argument);
+        REQUIRE(built == 1);
+
+        REQUIRE(check({ "-v", "commit", "--message", "fix", "--all", "a.txt", "b.txt" }));
+        REQUIRE(built == 1);
+        REQUIRE(result.isDefined(verbose));
+        REQUIRE(result.subcommand() == "commit");
+
+        const parser::ParseResult* commit = result.subcommandResult();
+        REQUIRE(commit != nullptr);
+        REQUIRE(commit->getArgumentView("--message") == "fix");
+        REQUIRE(commit->isDefined("--all"));
+        REQUIRE(commit->values("files").size() == 2);
+
+        REQUIRE(check({ "push", "origin" }));
+        REQUIRE(built == 2);
+        REQUIRE(result.subcommandResult()->getArgumentView("remote") == "origin");
+    }
+
+    SECTION("No subcommand"){
+        REQUIRE(check({ "-v" }));
+        REQUIRE(result.subcommand().empty());
+        REQUIRE(result.subcommandResult() == nullptr);
+
+        REQUIRE(check({ "pull" }).code == parser::parse_errc::unexpected_argument);
+        REQUIRE(built == 0);
+    }
+
+    SECTION("Errors point into the whole argv"){
+        auto status = check({ "-v", "push", "origin", "main" });
+        REQUIRE(status.code == parser::parse_errc::unexpected_argument);
+        REQUIRE(status.index == 4);
+        REQUIRE(status.token == "main");
+
+        char *argv[] = { "tool", "push" };
+        try
+        {
+            schema.parse(2, argv, result);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.code() == parser::parse_errc::missing_argument);
+            REQUIRE(e.usage().find("tool push") != std::string::npos);
+        }
+    }
+
+    SECTION("Subcommand schemas"){
+        REQUIRE(schema.subcommand("unknown") == nullptr);
+        const parser::Schema* push = schema.subcommand("push");
+        REQUIRE(push != nullptr);
+        REQUIRE(push->isFrozen());
+        REQUIRE(push->subcommand("push") == nullptr);
+        REQUIRE(schema.subcommand("push") == push);
+        REQUIRE(built == 1);
+
+        // Copies build their own
+        parser::Schema copy(schema);
+        REQUIRE(copy.subcommand("push") != push);
+        REQUIRE(built == 2);
+
+        REQUIRE(schema.usage().find("[ commit ] => Record changes") != std::string::npos);
+    }
+
+    SECTION("Built once by many threads"){
+        std::vector<parser::command_line> lines;
+        char *argv[] = { "tool", "commit", "--all" };
+        for(int i = 0; i < 64; i++)
+            lines.push_back({ 3, argv });
+
+        auto entries = schema.parseBatch(lines, 8);
+        REQUIRE(built == 1);
+        for(auto&& entry : entries)
+            REQUIRE(entry.result.subcommandResult()->isDefined("--all"));
+    }
+
+    SECTION("Through ArgumentParser"){
+        char *argv[] = { "tool", "push", "origin" };
+        parser::ArgumentParser argParser(3, argv);
+        argParser.addSubcommand("push", [](parser::Schema& push) { push.addPositional("remote"); });
+        argParser.parse();
+        REQUIRE(argParser.subcommand() == "push");
+        REQUIRE(argParser.subcommandResult()->getArgumentView("remote") == "origin");
+    }
+
+    SECTION("Copies outlive the source"){
+        char *argv[] = { "tool", "push", "origin" };
+        auto source = std::make_unique<parser::ArgumentParser>(3, argv);
+        source->addSubcommand("push", [](parser::Schema& push) { push.addPositional("remote"); });
+        source->parse();
+
+        parser::ArgumentParser copy(*source);
+        parser::ArgumentParser assigned(1, argv);
+        assigned = *source;
+        source.reset();
+
+        REQUIRE(copy.subcommand() == "push");
+        REQUIRE(copy.subcommandResult()->schema() != nullptr);
+        REQUIRE(copy.subcommandResult()->schema()->isFrozen());
+        REQUIRE(copy.subcommandResult()->getArgumentView("remote") == "origin");
+        REQUIRE(assigned.subcommandResult()->values("remote").size() == 1);
+    }
+
+    SECTION("Reused results forget the last subcommand"){
+        char *pushArgv[] = { "tool", "push", "origin" };
+        char *wrongArgv[] = { "tool", "--wrong", "push", "origin" };
+
+        parser::ParseResult reused;
+        schema.parse(3, pushArgv, reused);
+        REQUIRE(reused.subcommand() == "push");
+
+        try
+        {
+            schema.parse(4, wrongArgv, reused);
+            FAIL("parsing_exception not thrown");
+        }
+        catch(parser::parsing_exception& e)
+        {
+            REQUIRE(e.token() == "--wrong");
+            REQUIRE(e.usage() == schema.usage());
+        }
+        REQUIRE(reused.subcommandResult() == nullptr);
+    }
+}
+
+
+TEST_CASE("Testing passthrough")
+{
+
+    parser::Schema schema("wrapper");
+    auto verbose = schema.addArgument("-v");
+    auto level = schema.addArgument("--level", true, "Level");
+    schema.addArgument("--quiet");
+    auto input = schema.addPositional("input", parser::arity::optional());
+    schema.enablePassthrough();
+    schema.freeze();
+
+    std::vector<char*> argv;
+    parser::ParseResult result;
+    auto check = [&schema, &result, &argv](std::vector<const char*> tokens)
+    {
+        argv = { const_cast<char*>("wrapper") };
+        for(auto token : tokens)
+            argv.push_back(const_cast<char*>(token));
+        result.clear();
+        return schema.tryParse(int(argv.size()), argv.data(), result);
+    };
+    auto forwarded = [&result, &argv]()
+    {
+        std::vector<std::string_view> tokens;
+        for(auto range : result.passthrough())
+            tokens.insert(tokens.end(), argv.begin() + range.begin, argv.begin() + range.end);
+        return tokens;
+    };
+    using views = std::vector<std::string_view>;
+
+    SECTION("Unknown options and their values"){
+        REQUIRE(check({ "in.dat", "--heap", "4g", "-v", "--gc=g1", "-Xss", "1m", "2m", "--level", "3" }));
+        REQUIRE(result.isDefined(verbose));
+        REQUIRE(result.getArgumentView(level) == "3");
+        REQUIRE(result.getArgumentView(input) == "in.dat");
+        REQUIRE(forwarded() == views{ "--heap", "4g", "--gc=g1", "-Xss", "1m", "2m" });
+
+        // Consecutive tokens share a range
+        REQUIRE(result.passthrough().size() == 2);
+        REQUIRE(result.passthrough()[0].begin == 2);
+        REQUIRE(result.passthrough()[0].end == 4);
+        REQUIRE(result.passthrough()[1].begin == 5);
+        REQUIRE(result.passthrough()[1].end == 9);
+    }
+
+    SECTION("Inline values end the unknown option"){
+        REQUIRE(check({ "--gc=g1", "in.dat" }));
+        REQUIRE(result.getArgumentView(input) == "in.dat");
+        REQUIRE(forwarded() == views{ "--gc=g1" });
+
+        parser::Schema required("wrapper");
+        auto file = required.addPositional("file");
+        required.enablePassthrough();
+        required.freeze();
+        char *tokens[] = { "wrapper", "--foo=bar", "keep" };
+        parser::ParseResult own;
+        REQUIRE(required.tryParse(3, tokens, own));
+        REQUIRE(own.getArgumentView(file) == "keep");
+        REQUIRE(own.passthrough().size() == 1);
+        REQUIRE(own.passthrough()[0].end == 2);
+    }
+
+    SECTION("Tokens without a place"){
+        REQUIRE(check({ "a", "b", "-v" }));
+        REQUIRE(result.getArgumentView(input) == "a");
+        REQUIRE(forwarded() == views{ "b" });
+    }
+
+    SECTION("Clusters are taken whole"){
+        REQUIRE(check({ "-vx" }));
+        REQUIRE_FALSE(result.isDefined(verbose));
+        REQUIRE(forwarded() == views{ "-vx" });
+    }
+
+    SECTION("Known arguments still fail when misused"){
+        REQUIRE(check({ "--level" }).code == parser::parse_errc::missing_value);
+        REQUIRE(check({ "--quiet=1" }).code == parser::parse_errc::unexpected_value);
+    }
+
+    SECTION("Disabled by default"){
+        parser::Schema strict("wrapper");
+        strict.addArgument("-v");
+        strict.freeze();
+        char *strictArgv[] = { "wrapper", "--heap" };
+        parser::ParseResult strictResult;
+        REQUIRE(strict.tryParse(2, strictArgv, strictResult).code == parser::parse_errc::unexpected_argument);
+        REQUIRE(strictResult.passthrough().empty());
+    }
+
+    SECTION("Inside subcommands"){
+        parser::Schema tool("tool");
+        tool.addSubcommand("run", [](parser::Schema& run)
+        {
+            run.addArgument("--fast");
+            run.enablePassthrough();
+        });
+        tool.freeze();
+
+        char *toolArgv[] = { "tool", "run", "--fast", "--jvm", "opt" };
+        parser::ParseResult toolResult;
+        REQUIRE(tool.tryParse(5, toolArgv, toolResult));
+        auto&& ranges = toolResult.subcommandResult()->passthrough();
+        REQUIRE(ranges.size() == 1);
+        REQUIRE(ranges[0].begin == 3);
+        REQUIRE(ranges[0].end == 5);
+    }
+
+    SECTION("Through ArgumentParser"){
+        char *parserArgv[] = { "wrapper", "--foreign", "-v" };
+        parser::ArgumentParser argParser(3, parserArgv);
+        argParser.addArgument("-v");
+        argParser.enablePassthrough();
+        argParser.parse();
+        REQUIRE(argParser.isDefined("-v"));
+        REQUIRE(argParser.passthrough().size() == 1);
+        REQUIRE(argParser.passthrough()[0].begin == 1);
+    }
+}